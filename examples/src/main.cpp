@@ -6,6 +6,7 @@
 #if ESP_GUI_BUILD_MAIN
 #include <Arduino.h>
 #include <esp-gui/Configuration.hpp>
+#include <esp-gui/StaticUi.hpp>
 #include <esp-gui/UpdateManager.hpp>
 #include <esp-gui/WebServer.hpp>
 #include <esp-gui/WifiManager.hpp>
@@ -27,8 +28,15 @@ String m_demoList = "demo_list";
 String m_demoDropdown = "demo_dropdown";
 String m_demoButton = "demo_button";
 String m_demoDropdownButton = "dropdown_demo_button";
+String m_demoIntButton = "demo_int_button";
 int m_listIdx = 0;
 
+// optional: containers without runtime state are built by the compiler into flash
+static constexpr auto s_staticUi PROGMEM = esp_gui::ui::page(esp_gui::ui::container(
+  "Static Demo",
+  esp_gui::ui::input<esp_gui::InputElementType::DOUBLE>("Demo double", "demo_double"),
+  esp_gui::ui::button("Log demo double", "demo_static_button")));
+
 void setup() {
   m_serialAppender.begin(115200);
   m_logger.log(yal::Level::INFO, "Running setup");
@@ -41,13 +49,23 @@ void setup() {
   m_config.setValue(m_demoInt, 42);
   m_config.setValue(m_demoString, "ESP-GUI");
 
-  esp_gui::Container demoContainer("Demo");
-  demoContainer.addInput(esp_gui::InputElementType::INT, String("Demo int"), m_demoInt);
+  esp_gui::Container demoContainer(F("Demo"));
+  demoContainer.addInput(esp_gui::InputElementType::INT, F("Demo int"), m_demoInt);
+  // every change of a value renders the page again and changes its etag,
+  // so values are changed on events and not periodically
+  demoContainer.addButton(F("Increment demo int"), m_demoIntButton, [] {
+    const auto current = m_config.value<int>(m_demoInt);
+    m_config.setValue(m_demoInt, current + 1);
+    // optional: this persists the value in eeprom.
+    // should not be done on a regular basis because eeprom has only 10k write cycles
+    // m_config.setValue(m_demoInt, current + 1, true);
+  });
   demoContainer.addInput(
-    esp_gui::InputElementType::STRING, String("Demo String"), m_demoString);
-  demoContainer.addList({"option 1", "hello", "world"}, String("Demo List"), m_demoList);
+    esp_gui::InputElementType::STRING, F("Demo String"), m_demoString);
+  demoContainer.addList(
+    {F("option 1"), F("hello"), F("world")}, F("Demo List"), m_demoList);
 
-  demoContainer.addButton(String("Append list item"), m_demoButton, [] {
+  demoContainer.addButton(F("Append list item"), m_demoButton, [] {
     const auto list = m_server.findElement<esp_gui::ListElement>(m_demoList);
     if (list == nullptr) {
       return;
@@ -55,9 +73,14 @@ void setup() {
     list->addOption("dynamic list item" + String(++m_listIdx));
   });
 
+  // options of long lists can be loaded by the browser when they are needed
   demoContainer.addDropdown(
-    {"Element 1", "Element 2", "Element 3"}, String("Demo Dropdown"), m_demoDropdown);
-  demoContainer.addButton(String("Append dropdown item"), m_demoDropdownButton, [] {
+    {"Element 1", "Element 2", "Element 3"},
+    F("Demo Dropdown"),
+    m_demoDropdown,
+    false,
+    esp_gui::OptionLoading::ON_DEMAND);
+  demoContainer.addButton(F("Append dropdown item"), m_demoDropdownButton, [] {
     const auto dropDown = m_server.findElement<esp_gui::DropDownElement>(m_demoDropdown);
     if (dropDown == nullptr) {
       return;
@@ -67,19 +90,30 @@ void setup() {
   // You can set the selected value programmatically like this
   // m_config.setValue(m_demoDropdown, "Element 3");
 
+  // called from loop() after the value was changed, e.g. through the web interface
+  m_config.subscribe(m_demoString, [] {
+    m_logger.log(
+      yal::Level::INFO,
+      "Demo string changed to %",
+      m_config.value<String>(m_demoString).c_str());
+  });
+
   m_server.addContainer(std::move(demoContainer));
+
+  m_server.setStaticUi(esp_gui::ui::view(s_staticUi));
+  m_server.onStaticButton(F("demo_static_button"), [] {
+    m_logger.log(
+      yal::Level::INFO, "Demo double is %", m_config.value<double>("demo_double"));
+  });
   m_wifiMgr.setup(false);
   m_updateManager.setup();
   m_server.setup(m_config.value<String>("wifi_hostname"));
 }
 
 void loop() {
+  // loop has to run without delays, the config portal answers dns queries from here
   m_wifiMgr.loop();
-  delay(1000);
-  int currentUsage = m_config.value<int>(m_demoInt);
-  m_config.setValue(m_demoInt, currentUsage + 1);
-  // optional: this persists the value in eeprom.
-  // should not be done on a regular basis because eeprom has only 10k write cycles
-  // m_config.setValue(m_demoInt, currentUsage + 1, true);
+  m_updateManager.loop();
+  m_config.loop();
 }
 #endif
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_ADMISSIONCONTROL_HPP
+#define ESP_GUI_ADMISSIONCONTROL_HPP
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp-gui/RequestMetrics.hpp>
+#include <array>
+
+namespace esp_gui {
+
+/**
+ * Decides if a request is handled or answered with 503 before it allocates.
+ * Limits the responses in flight per route class and sheds all requests while free
+ * heap or the largest free block are below the thresholds.
+ */
+class AdmissionControl {
+ public:
+  enum class RouteClass : uint8_t {
+    // pages rendered from templates, the most expensive responses
+    PAGE,
+    // posts which change the configuration or click buttons
+    ACTION,
+    // small static responses: redirects, 404, metrics
+    PROBE,
+    // reboot, not subject to the heap thresholds so the device stays recoverable
+    CONTROL,
+    // file uploads, admitted on their first chunk and one at a time
+    UPLOAD,
+  };
+
+  static constexpr size_t s_routeClasses = 5;
+  static constexpr unsigned long s_uploadIdleMillis = 10000;
+
+  /**
+   * @param limit responses of the class which may be sent at the same time,
+   * 0 for no limit. Not used for uploads.
+   */
+  void setConcurrency(RouteClass routeClass, uint8_t limit) {
+    m_limits[static_cast<size_t>(routeClass)] = limit;
+  }
+
+  void setHeapThresholds(uint32_t minFreeHeap, uint32_t minMaxFreeBlock) {
+    m_minFreeHeap = minFreeHeap;
+    m_minMaxFreeBlock = minMaxFreeBlock;
+  }
+
+  void setRetryAfter(uint16_t seconds) {
+    m_retryAfterSeconds = seconds;
+  }
+
+  [[nodiscard]] uint16_t retryAfter() const {
+    return m_retryAfterSeconds;
+  }
+
+  void addRoute(size_t route, RouteClass routeClass) {
+    m_routeClasses[route] = routeClass;
+  }
+
+  [[nodiscard]] RouteClass routeClass(size_t route) const {
+    return m_routeClasses[route];
+  }
+
+  /**
+   * @return nullptr if the request may be handled, the reason otherwise
+   */
+  [[nodiscard]] const char* admit(size_t route, const RequestMetrics& metrics) const;
+
+  /**
+   * Called for every chunk of an upload
+   * @return nullptr if the chunk may be processed, the reason otherwise
+   */
+  const char* admitUpload(AsyncWebServerRequest* request, size_t index, bool final);
+
+  /**
+   * @return true if the upload of request was rejected, clears the rejection
+   */
+  bool uploadRejected(AsyncWebServerRequest* request) {
+    const auto rejected = request == m_rejectedUpload;
+    m_rejectedUpload = nullptr;
+    return rejected;
+  }
+
+ private:
+  [[nodiscard]] const char* checkHeap() const;
+
+  std::array<RouteClass, RequestMetrics::s_maxRoutes> m_routeClasses{};
+  std::array<uint8_t, s_routeClasses> m_limits{2, 2, 4, 1, 1};
+
+  uint32_t m_minFreeHeap = 8192;
+  uint32_t m_minMaxFreeBlock = 4096;
+  uint16_t m_retryAfterSeconds = 5;
+
+  // only compared, the requests may already be destroyed
+  const AsyncWebServerRequest* m_upload = nullptr;
+  const AsyncWebServerRequest* m_rejectedUpload = nullptr;
+  unsigned long m_uploadActivity = 0;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_ADMISSIONCONTROL_HPP
@@ -11,11 +11,17 @@
 #include <LittleFS.h>
 #include <yal/yal.hpp>
 #include <any>
+#include <array>
+#include <functional>
 #include <map>
+#include <sstream>
+#include <vector>
 
 namespace esp_gui {
 class Configuration {
  public:
+  using OnChange = std::function<void()>;
+
   Configuration() : m_config(DynamicJsonDocument(m_jsonData.size())) {
   }
   Configuration(Configuration&) = delete;
@@ -34,6 +40,21 @@ class Configuration {
     return m_config[key];
   }
 
+  /**
+   * @return value of key as text, numbers and booleans are formatted as json
+   */
+  [[nodiscard]] String text(const String& key) const {
+    const auto value = m_config[key];
+    if (value.is<const char*>()) {
+      return value.as<const char*>();
+    }
+    String text;
+    if (!value.isNull()) {
+      ArduinoJson6194_F1::serializeJson(value, text);
+    }
+    return text;
+  }
+
   template<typename T>
   void setValue(const String& key, T value, bool persist = false) {
     logKV(key, value);
@@ -43,31 +64,153 @@ class Configuration {
       return;
     }
     m_config[key] = value;
+    ++m_version;
+    changed(key);
     if (persist) {
       store();
     }
   }
 
+  /**
+   * Sets all values at once and stores the configuration a single time.
+   * Strings are copied, values may point into a buffer freed afterwards.
+   * Nothing is changed if the values do not fit into the configuration.
+   * @return false if the values do not fit
+   */
+  bool setValues(JsonObjectConst values);
+
+  [[nodiscard]] bool contains(const String& key) const {
+    return m_config.containsKey(key);
+  }
+
+  /**
+   * Writes the configuration as json to out without an intermediate copy
+   */
+  void serialize(Print& out) const {
+    ArduinoJson6194_F1::serializeJson(m_config, out);
+  }
+
+  /**
+   * @return all values, e.g. to serialize a part of them
+   */
+  [[nodiscard]] JsonObjectConst values() const {
+    return m_config.as<JsonObjectConst>();
+  }
+
+  /**
+   * @return bytes available for the json document
+   */
+  [[nodiscard]] size_t capacity() const {
+    return m_jsonData.size();
+  }
+
+  [[nodiscard]] JsonArrayConst array(const String& key) const {
+    return m_config[key].as<JsonArrayConst>();
+  }
+
+  /**
+   * Replaces the value of key with an empty array that can be filled by the caller
+   */
+  JsonArray createArray(const String& key) {
+    ++m_version;
+    changed(key);
+    m_config.remove(key);
+    return m_config.createNestedArray(key);
+  }
+
+  /**
+   * @return counter which is increased on every change of a value, starts at 0 on
+   * each boot
+   */
+  [[nodiscard]] uint32_t version() const {
+    return m_version;
+  }
+
   void setup();
   void store();
   void reset(bool persist);
 
+  /**
+   * Calls onChange from loop() after key was changed by setValue, createArray,
+   * reset, setup or reload. Changes until the next loop() result in one call.
+   * An empty key is called for changes of any key.
+   * Subscribing from within a callback is not allowed.
+   * @return id for unsubscribe
+   */
+  size_t subscribe(const String& key, OnChange&& onChange);
+  void unsubscribe(size_t id);
+
+  /**
+   * Dispatches pending change notifications, call it from the sketch loop()
+   */
+  void loop();
+
+  /**
+   * Reads the config file again, e.g. after the file system image was replaced.
+   * Values already set take precedence, only missing keys are taken from the file.
+   */
+  void reload();
+
+  /**
+   * While locked the file system is not mounted, e.g. during a file system update.
+   * Locking unmounts it, handles which are still alive do not mount it again.
+   */
+  static void lockFileSystem(bool locked) {
+    s_fileSystemLocked = locked;
+    if (locked) {
+      ++s_fileSystemMount;
+      s_fileSystemUsers = 0;
+      LittleFS.end();
+    }
+  }
+
+  [[nodiscard]] static bool fileSystemLocked() {
+    return s_fileSystemLocked;
+  }
+
+  /**
+   * Keeps the file system mounted from begin() until the last handle is destroyed,
+   * e.g. by a response which streams a file
+   */
   struct FileSystemHandle {
     FileSystemHandle() = default;
+    FileSystemHandle(const FileSystemHandle&) = delete;
+    FileSystemHandle& operator=(const FileSystemHandle&) = delete;
+
+    FileSystemHandle(FileSystemHandle&& other) noexcept :
+        m_mount(other.m_mount), m_mounted(other.m_mounted) {
+      other.m_mounted = false;
+    }
+
     bool begin() {
-      if (!LittleFS.begin()) {
+      if (m_mounted) {
+        return true;
+      }
+      if (s_fileSystemLocked) {
+        m_logger.log(yal::Level::WARNING, "file system is locked");
+        return false;
+      }
+      if (s_fileSystemUsers == 0 && !LittleFS.begin()) {
         m_logger.log(yal::Level::ERROR, "failed to init littlefs");
         return false;
       }
+      ++s_fileSystemUsers;
+      m_mount = s_fileSystemMount;
+      m_mounted = true;
       return true;
     }
 
     ~FileSystemHandle() {
-      LittleFS.end();
+      // a lock in between already unmounted the file system
+      if (m_mounted && m_mount == s_fileSystemMount && --s_fileSystemUsers == 0) {
+        LittleFS.end();
+      }
     }
 
    private:
     yal::Logger m_logger = yal::Logger("CONFIG");
+    uint32_t m_mount = 0;
+    bool m_mounted = false;
   };
 
   struct FileHandle {
@@ -117,9 +260,27 @@ class Configuration {
     m_logger.log(yal::Level::DEBUG, "Set '%' to '%'", key.c_str(), val.c_str());
   }
 
+  /**
+   * Marks the subscriptions of key as pending, all of them if key is empty
+   */
+  void changed(const String& key);
+
+  struct Subscription {
+    String key;
+    OnChange onChange;
+    bool pending = false;
+  };
+
   yal::Logger m_logger = yal::Logger("CONFIG");
   DynamicJsonDocument m_config;
+  uint32_t m_version = 0;
+  std::vector<Subscription> m_subscriptions;
+  bool m_changesPending = false;
   static constexpr const char* m_configFile = "/esp-gui-config.dat";
+  static inline bool s_fileSystemLocked = false;
+  // handles which mounted the file system, reset by a lock which starts a new mount
+  static inline size_t s_fileSystemUsers = 0;
+  static inline uint32_t s_fileSystemMount = 0;
 
   std::array<uint8_t, 2048> m_jsonData;  // todo move outside
 };
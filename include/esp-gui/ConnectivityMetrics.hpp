@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_CONNECTIVITYMETRICS_HPP
+#define ESP_GUI_CONNECTIVITYMETRICS_HPP
+
+#include <Arduino.h>
+#include <array>
+
+namespace esp_gui {
+
+/**
+ * Connection statistics of the WifiManager, fixed size and updated in place.
+ */
+class ConnectivityMetrics {
+ public:
+  // upper bounds of the time to connect histogram in ms, the last bucket takes the rest
+  static constexpr std::array<uint32_t, 6> s_connectBuckets{
+    500, 1000, 2000, 4000, 8000, 16000};
+  using Histogram = std::array<uint32_t, s_connectBuckets.size() + 1>;
+
+  void recordConnectTime(uint32_t durationMs);
+  void recordAttempt(bool success);
+  void recordOffline(unsigned long nowMillis);
+  void recordOnline(unsigned long nowMillis);
+
+  void setRssi(int32_t rssi) {
+    m_lastRssi = rssi;
+  }
+
+  [[nodiscard]] const Histogram& connectHistogram() const {
+    return m_connectHistogram;
+  }
+
+  [[nodiscard]] uint32_t disconnects() const {
+    return m_disconnects;
+  }
+
+  [[nodiscard]] uint32_t attempts() const {
+    return m_attempts;
+  }
+
+  [[nodiscard]] uint32_t failedAttempts() const {
+    return m_failedAttempts;
+  }
+
+  [[nodiscard]] int32_t lastRssi() const {
+    return m_lastRssi;
+  }
+
+  [[nodiscard]] bool online() const {
+    return m_online;
+  }
+
+  /**
+   * @return total time spent offline including the current offline period
+   */
+  [[nodiscard]] uint64_t offlineMillis(unsigned long nowMillis) const;
+
+ private:
+  Histogram m_connectHistogram{};
+  uint32_t m_disconnects = 0;
+  uint32_t m_attempts = 0;
+  uint32_t m_failedAttempts = 0;
+  int32_t m_lastRssi = 0;
+  bool m_online = false;
+  // the device starts offline, boot counts towards the offline time
+  unsigned long m_offlineSinceMillis = 0;
+  uint64_t m_offlineMillis = 0;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_CONNECTIVITYMETRICS_HPP
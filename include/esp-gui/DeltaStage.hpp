@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_DELTASTAGE_HPP
+#define ESP_GUI_DELTASTAGE_HPP
+
+#include <esp-gui/UploadPipeline.hpp>
+#include <lwip/opt.h>
+#include <yal/yal.hpp>
+#include <array>
+#include <memory>
+
+namespace esp_gui {
+
+/**
+ * Rebuilds a firmware image from a patch against the running sketch, see
+ * tools/esp_delta.py for the encoder. All values are little endian.
+ *
+ * header:  "EGD1", u32 base size, u8[16] base md5, u32 target size
+ * copy:    0x01, u32 offset in the base, u32 length
+ * literal: 0x02, u32 length, length bytes
+ *
+ * A few bytes of patch can describe hundreds of kilobytes of image, so the image
+ * is not produced in the tcp receive path. The patch is buffered and decoded from
+ * loop() while acks are held back, the sender can not outrun the flash.
+ */
+class DeltaStage : public UploadStage {
+ public:
+  // holds everything the sender may transmit without an ack
+  static constexpr size_t s_inputSize = TCP_WND + TCP_MSS;
+  static constexpr size_t s_outputPerLoop = FLASH_SECTOR_SIZE;
+
+  DeltaStage() : m_logger(yal::Logger("DELTA")) {
+  }
+
+  bool begin(AsyncWebServerRequest* request, const String& filename) override;
+  bool write(const uint8_t* data, size_t len) override;
+  bool end() override;
+  void abort() override;
+  void disconnected() override;
+  void loop() override;
+
+  [[nodiscard]] bool busy() const override {
+    return m_state != State::IDLE || UploadStage::busy();
+  }
+
+ private:
+  enum class State { IDLE, HEADER, OPCODE, COPY, LITERAL };
+
+  static constexpr uint8_t s_opCopy = 0x01;
+  static constexpr uint8_t s_opLiteral = 0x02;
+  static constexpr size_t s_headerSize = 28;
+  static constexpr size_t s_copyChunk = 256;
+
+  /**
+   * @return false if more input is needed or the output budget is used up
+   */
+  bool step(size_t& budget);
+  bool parseHeader();
+  bool parseOpcode();
+  void finish();
+  void fail(const char* error);
+  void releaseAck();
+
+  [[nodiscard]] size_t available() const {
+    return m_inputSize - m_inputPos;
+  }
+
+  void consume(size_t len) {
+    m_inputPos += len;
+    m_consumed += len;
+  }
+
+  static uint32_t readU32(const uint8_t* data);
+
+  yal::Logger m_logger;
+  State m_state = State::IDLE;
+  AsyncClient* m_client = nullptr;
+  size_t m_pendingAck = 0;
+  size_t m_consumed = 0;
+
+  std::unique_ptr<uint8_t[]> m_input;
+  size_t m_inputPos = 0;
+  size_t m_inputSize = 0;
+  bool m_inputComplete = false;
+
+  uint32_t m_baseSize = 0;
+  uint32_t m_targetSize = 0;
+  uint32_t m_produced = 0;
+  uint32_t m_copyOffset = 0;
+  uint32_t m_remaining = 0;
+  std::array<uint8_t, s_copyChunk> m_copyBuffer{};
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_DELTASTAGE_HPP
@@ -0,0 +1,22 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_ELEMENTTYPE_HPP
+#define ESP_GUI_ELEMENTTYPE_HPP
+
+namespace esp_gui {
+
+enum class InputElementType { STRING, PASSWORD, INT, DOUBLE };
+enum class ElementType { STRING, PASSWORD, INT, DOUBLE, LIST, BUTTON, UPLOAD, DROPDOWN };
+
+/**
+ * INLINE renders all options into the page, ON_DEMAND lets the browser load them
+ * page by page from /options while the user types or opens the element
+ */
+enum class OptionLoading { INLINE, ON_DEMAND };
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_ELEMENTTYPE_HPP
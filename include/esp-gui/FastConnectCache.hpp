@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FASTCONNECTCACHE_HPP
+#define ESP_GUI_FASTCONNECTCACHE_HPP
+
+#include <Arduino.h>
+#include <yal/yal.hpp>
+#include <array>
+
+namespace esp_gui {
+
+/**
+ * Persists the parameters of the last successful connection in RTC memory.
+ * RTC memory survives deep sleep and resets, so waking nodes can connect directly
+ * to the known BSSID and channel without scanning first.
+ */
+class FastConnectCache {
+ public:
+  static constexpr size_t s_bssidLength = 6;
+
+  struct Entry {
+    std::array<uint8_t, s_bssidLength> bssid{};
+    uint16_t reserved = 0;  // explicit padding, the record is compared bytewise
+    int32_t channel = 0;
+    // last lease, only used when reusing the ip lease is enabled
+    uint32_t ip = 0;
+    uint32_t gateway = 0;
+    uint32_t subnet = 0;
+    uint32_t dns = 0;
+  };
+
+  FastConnectCache() : m_logger(yal::Logger("FASTCON")) {
+  }
+
+  /**
+   * Loads the cached entry
+   * @param ssid the entry is only valid if it was stored for the same ssid
+   * @return true if a valid entry was found
+   */
+  bool load(const String& ssid, Entry& entry);
+  void store(const String& ssid, const Entry& entry);
+  void invalidate();
+
+ private:
+  struct Record {
+    uint32_t crc;
+    uint32_t magic;
+    uint32_t ssidHash;
+    Entry entry;
+  };
+
+  static_assert(sizeof(Record) % sizeof(uint32_t) == 0, "rtc memory is word aligned");
+  static_assert(sizeof(Entry) == 28, "entry must not contain implicit padding");
+
+  static uint32_t recordCrc(const Record& record);
+  static uint32_t ssidHash(const String& ssid);
+
+  yal::Logger m_logger;
+
+  // user rtc memory is shared with the application, keep the record at the end
+  static constexpr uint32_t s_rtcOffset = (512 - sizeof(Record)) / sizeof(uint32_t);
+  static constexpr uint32_t s_magic = 0x45474643;  // EGFC
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_FASTCONNECTCACHE_HPP
@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FLASHPAGE_HPP
+#define ESP_GUI_FLASHPAGE_HPP
+
+#include <Arduino.h>
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace esp_gui {
+
+/**
+ * Page template which stays where it is, usually in flash. The placeholders are
+ * located once when a region is added, requests copy the bytes between them
+ * straight into the response buffer and only resolve the placeholders.
+ * Same rules as the template processor of the web server: %name% is replaced,
+ * %% is a single % and names longer than 32 characters are kept as they are.
+ */
+class FlashPage {
+ public:
+  using Resolve = std::function<String(const String& name)>;
+
+  static constexpr size_t s_maxNameLength = 32;
+  static constexpr size_t s_maxParts = 4;
+
+  /**
+   * The bytes have to stay valid, they are read with memcpy_P
+   * @return index of the region
+   */
+  size_t addRegion(PGM_P data, size_t length);
+
+  [[nodiscard]] size_t regionLength(size_t region) const {
+    return m_regions.at(region).length;
+  }
+
+  struct Part {
+    size_t region;
+    size_t offset;
+    size_t length;
+  };
+
+  /**
+   * Renders a sequence of region parts, a part must not split a placeholder
+   */
+  class Reader {
+   public:
+    Reader(const FlashPage& page, Resolve&& resolve) :
+        m_page(page), m_resolve(std::move(resolve)) {
+    }
+
+    void add(const Part& part);
+
+    /**
+     * @return number of bytes written to buffer, 0 once the page is complete
+     */
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+   private:
+    void startPart();
+
+    const FlashPage& m_page;
+    Resolve m_resolve;
+    std::array<Part, s_maxParts> m_parts{};
+    size_t m_partCount = 0;
+    size_t m_part = 0;
+    bool m_started = false;
+    size_t m_position = 0;
+    size_t m_slot = 0;
+    String m_value;
+    size_t m_valueOffset = 0;
+  };
+
+ private:
+  struct Slot {
+    size_t offset;
+    // including both %
+    uint8_t length;
+  };
+
+  struct Region {
+    PGM_P data;
+    size_t length;
+    std::vector<Slot> slots;
+  };
+
+  std::vector<Region> m_regions;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_FLASHPAGE_HPP
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FLASHSTRING_HPP
+#define ESP_GUI_FLASHSTRING_HPP
+
+#include <Arduino.h>
+#include <ostream>
+
+namespace esp_gui {
+
+/**
+ * Text of the user interface. Literals given with F() or FPSTR() stay in flash, all
+ * other text is copied to the heap.
+ */
+class FlashString {
+ public:
+  FlashString() = default;
+
+  FlashString(const __FlashStringHelper* text) : m_flash(text) {
+  }
+
+  /**
+   * text has to be in ram, it is read without memcpy_P. A PROGMEM or PSTR() pointer
+   * has the same type, wrap it with FPSTR() or use fromProgmem().
+   */
+  FlashString(const char* text) : m_ram(text) {
+  }
+
+  /**
+   * Keeps a pointer to text in flash, e.g. a PROGMEM array or PSTR()
+   */
+  [[nodiscard]] static FlashString fromProgmem(PGM_P text) {
+    return FlashString(FPSTR(text));
+  }
+
+  FlashString(String text) : m_ram(std::move(text)) {
+  }
+
+  [[nodiscard]] bool inFlash() const {
+    return m_flash != nullptr;
+  }
+
+  [[nodiscard]] size_t length() const;
+
+  [[nodiscard]] bool isEmpty() const {
+    return length() == 0;
+  }
+
+  /**
+   * @return copy of the text, allocates for text in flash which does not fit the
+   * small string buffer
+   */
+  [[nodiscard]] String toString() const {
+    return m_flash != nullptr ? String(m_flash) : m_ram;
+  }
+
+  /**
+   * @return less than, equal to or greater than 0 like strcmp
+   */
+  [[nodiscard]] int compare(const char* other) const;
+  [[nodiscard]] int compare(const FlashString& other) const;
+
+  [[nodiscard]] bool startsWith(const String& prefix) const;
+
+  bool operator==(const String& other) const {
+    return compare(other.c_str()) == 0;
+  }
+
+  bool operator!=(const String& other) const {
+    return !(*this == other);
+  }
+
+  void appendTo(String& out) const;
+
+  friend std::ostream& operator<<(std::ostream& out, const FlashString& text);
+
+ private:
+  const __FlashStringHelper* m_flash = nullptr;
+  String m_ram;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_FLASHSTRING_HPP
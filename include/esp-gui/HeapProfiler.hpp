@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_HEAPPROFILER_HPP
+#define ESP_GUI_HEAPPROFILER_HPP
+
+#include <Arduino.h>
+#include <array>
+
+namespace esp_gui {
+
+/**
+ * Records retained heap and peak usage of named phases, e.g. loading the config,
+ * checking the html index, rendering templates or handling a request.
+ * Scopes can be nested, the peak of a scope includes its nested scopes.
+ * The peak uses the low watermark of umm_malloc if the core provides it, otherwise
+ * only the free heap at begin and end of a scope is known.
+ */
+class HeapProfiler {
+ public:
+  static constexpr size_t s_maxPhases = 24;
+
+  struct Phase {
+    const char* name = nullptr;
+    uint32_t runs = 0;
+    // bytes still allocated when the phase ended, negative if memory was freed
+    int32_t lastRetained = 0;
+    int32_t maxRetained = 0;
+    // highest usage above the free heap at the start of the phase
+    uint32_t lastPeak = 0;
+    uint32_t maxPeak = 0;
+    // smallest largest free block at the end of the phase
+    uint32_t minMaxBlock = UINT32_MAX;
+  };
+
+  class Scope {
+   public:
+    /**
+     * @param name has to outlive the profiler, phases are identified by the pointer
+     */
+    explicit Scope(const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const char* const m_name;
+    Scope* const m_parent;
+    const uint32_t m_startFree;
+    // watermark of the parent before it was reset for this scope
+    const uint32_t m_outerMin;
+    uint32_t m_nestedMin = UINT32_MAX;
+  };
+
+  [[nodiscard]] static size_t phaseCount() {
+    return s_phaseCount;
+  }
+
+  [[nodiscard]] static const Phase& phase(size_t index) {
+    return s_phases[index];
+  }
+
+  [[nodiscard]] static uint32_t maxFreeBlock() {
+    return EspClass::getMaxFreeBlockSize();
+  }
+
+  [[nodiscard]] static uint8_t fragmentation() {
+    return EspClass::getHeapFragmentation();
+  }
+
+ private:
+  static uint32_t lowWatermark();
+  static void resetLowWatermark();
+  static void record(const char* name, int32_t retained, uint32_t peak);
+
+  static std::array<Phase, s_maxPhases> s_phases;
+  static size_t s_phaseCount;
+  static Scope* s_current;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_HEAPPROFILER_HPP
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_IMAGEVERIFIER_HPP
+#define ESP_GUI_IMAGEVERIFIER_HPP
+
+#include <Arduino.h>
+#include <MD5Builder.h>
+#include <bearssl/bearssl_hash.h>
+#include <yal/yal.hpp>
+#include <array>
+
+namespace esp_gui {
+
+/**
+ * Verifies size and digests of a stream while it is received.
+ * No read back of the written data is necessary.
+ */
+class ImageVerifier {
+ public:
+  static constexpr size_t s_md5Length = 16;
+  static constexpr size_t s_sha256Length = 32;
+
+  ImageVerifier() : m_logger(yal::Logger("VERIFY")) {
+  }
+
+  /**
+   * @param expectedSize 0 if unknown
+   * @param md5 expected md5 as hex string, empty to skip
+   * @param sha256 expected sha256 as hex string, empty to skip
+   * @return false if a digest is malformed
+   */
+  bool begin(size_t expectedSize, const String& md5, const String& sha256);
+
+  /**
+   * @return false as soon as more data than expected was received
+   */
+  bool update(const uint8_t* data, size_t len);
+
+  /**
+   * @return true if size and digests match the expected values
+   */
+  bool finish();
+
+  [[nodiscard]] size_t size() const {
+    return m_size;
+  }
+
+  [[nodiscard]] const char* error() const {
+    return m_error;
+  }
+
+ private:
+  static bool parseHex(const String& hex, uint8_t* out, size_t len);
+
+  yal::Logger m_logger;
+
+  size_t m_expectedSize = 0;
+  size_t m_size = 0;
+  const char* m_error = nullptr;
+
+  bool m_checkMd5 = false;
+  MD5Builder m_md5{};
+  std::array<uint8_t, s_md5Length> m_expectedMd5{};
+
+  bool m_checkSha256 = false;
+  br_sha256_context m_sha256{};
+  std::array<uint8_t, s_sha256Length> m_expectedSha256{};
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_IMAGEVERIFIER_HPP
@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_OTAPIPELINE_HPP
+#define ESP_GUI_OTAPIPELINE_HPP
+
+#include <Arduino.h>
+#include <ESPAsyncTCP.h>
+#include <yal/yal.hpp>
+#include <array>
+#include <memory>
+
+namespace esp_gui {
+
+/**
+ * Collects upload data into two sector sized buffers. Full buffers are written to
+ * flash from loop(), so erasing and writing does not block the tcp receive path.
+ * While a full buffer waits for the flash, tcp acks are held back to throttle the
+ * sender.
+ */
+class OtaPipeline {
+ public:
+  static constexpr size_t s_bufferSize = FLASH_SECTOR_SIZE;
+
+  enum class State { IDLE, RECEIVING, FINISHED, FAILED };
+
+  OtaPipeline() : m_logger(yal::Logger("OTA")) {
+  }
+
+  /**
+   * @param size maximum image size
+   * @param command U_FLASH or U_FS
+   * @param client connection to throttle, may be nullptr
+   */
+  bool begin(size_t size, int command, AsyncClient* client);
+  bool write(const uint8_t* data, size_t len);
+
+  /**
+   * Writes the remaining data and finalizes the update
+   */
+  bool end();
+  void abort();
+
+  /**
+   * Aborts a running update without touching the closed connection
+   */
+  void clientDisconnected() {
+    m_client = nullptr;
+    abort();
+  }
+
+  void loop();
+
+  [[nodiscard]] State state() const {
+    return m_state;
+  }
+
+  [[nodiscard]] size_t received() const {
+    return m_received;
+  }
+
+  [[nodiscard]] size_t written() const {
+    return m_written;
+  }
+
+  [[nodiscard]] unsigned long elapsedMillis() const;
+
+  [[nodiscard]] uint32_t bytesPerSecond() const;
+
+ private:
+  bool flush(size_t index);
+  void releaseAck();
+  void release();
+
+  yal::Logger m_logger;
+
+  std::unique_ptr<uint8_t[]> m_buffers;
+  std::array<size_t, 2> m_sizes{};
+  size_t m_fillIndex = 0;
+
+  AsyncClient* m_client = nullptr;
+  size_t m_pendingAck = 0;
+
+  State m_state = State::IDLE;
+  size_t m_received = 0;
+  size_t m_written = 0;
+  unsigned long m_startMillis = 0;
+  unsigned long m_endMillis = 0;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_OTAPIPELINE_HPP
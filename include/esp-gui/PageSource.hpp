@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_PAGESOURCE_HPP
+#define ESP_GUI_PAGESOURCE_HPP
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp-gui/Configuration.hpp>
+#include <array>
+#include <cstdint>
+
+namespace esp_gui {
+
+/**
+ * Reads the page template from its segments in order. Segments are either bytes in
+ * flash or a file. Once a file is read the source keeps the file system mounted
+ * until it is destroyed, a response holding the source streams safely.
+ */
+class PageSource {
+ public:
+  static constexpr size_t s_maxSegments = 4;
+
+  void addFlash(PGM_P data, size_t length);
+
+  /**
+   * Adds length bytes of the file starting at offset, by default the whole file
+   */
+  void addFile(const char* path, size_t offset = 0, size_t length = SIZE_MAX);
+
+  /**
+   * @return number of bytes copied into buffer, 0 once all segments were read
+   */
+  size_t read(uint8_t* buffer, size_t maxLen);
+
+ private:
+  struct Segment {
+    PGM_P data = nullptr;
+    size_t length = 0;
+    const char* path = nullptr;
+    size_t offset = 0;
+  };
+
+  std::array<Segment, s_maxSegments> m_segments{};
+  size_t m_segmentCount = 0;
+  size_t m_current = 0;
+  size_t m_offset = 0;
+  Configuration::FileSystemHandle m_fileSystem;
+  File m_file;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_PAGESOURCE_HPP
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_RECONNECTPOLICY_HPP
+#define ESP_GUI_RECONNECTPOLICY_HPP
+
+#include <Arduino.h>
+#include <chrono>
+
+namespace esp_gui {
+
+using std::chrono_literals::operator""s;
+using std::chrono_literals::operator""min;
+
+struct ReconnectConfig {
+  std::chrono::milliseconds initialDelay = 1s;
+  std::chrono::milliseconds maxDelay = 5min;
+  float multiplier = 2.0F;
+  // fraction of the delay which is randomized, spreads devices losing the same ap
+  float jitter = 0.25F;
+};
+
+/**
+ * Computes the delay before the next reconnect attempt using exponential backoff.
+ */
+class ReconnectPolicy {
+ public:
+  ReconnectPolicy() = default;
+  explicit ReconnectPolicy(const ReconnectConfig& config) : m_config(config) {
+  }
+
+  void setConfig(const ReconnectConfig& config) {
+    m_config = config;
+  }
+
+  /**
+   * @return delay before the next attempt, advances the backoff
+   */
+  std::chrono::milliseconds nextDelay();
+
+  void reset() {
+    m_attempts = 0;
+  }
+
+  [[nodiscard]] uint32_t attempts() const {
+    return m_attempts;
+  }
+
+ private:
+  ReconnectConfig m_config;
+  uint32_t m_attempts = 0;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_RECONNECTPOLICY_HPP
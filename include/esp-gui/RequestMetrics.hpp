@@ -0,0 +1,231 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_REQUESTMETRICS_HPP
+#define ESP_GUI_REQUESTMETRICS_HPP
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <yal/yal.hpp>
+#include <array>
+
+// routes an application may add with WebServer::on() or upload elements
+#ifndef ESP_GUI_APP_ROUTES
+#define ESP_GUI_APP_ROUTES 8
+#endif
+
+namespace esp_gui {
+
+/**
+ * Request counters, latency histograms and heap watermarks of the web server,
+ * including the phases recorded by the HeapProfiler.
+ * All storage is allocated upfront, routes beyond s_maxRoutes share one slot.
+ * Rendered in the prometheus text format.
+ */
+class RequestMetrics {
+ public:
+  // WebServer::setup registers 14 routes, the UpdateManager GET and POST of its
+  // three uploads and /update/progress
+  static constexpr size_t s_libraryRoutes = 21;
+  // one more for the slot shared by the routes which do not fit
+  static constexpr size_t s_maxRoutes = s_libraryRoutes + ESP_GUI_APP_ROUTES + 1;
+  static constexpr std::array<uint32_t, 9> s_latencyBucketsMs =
+    {5, 10, 25, 50, 100, 250, 500, 1000, 2500};
+
+  /**
+   * @return index of the route, registering the same uri twice returns the same index
+   */
+  size_t addRoute(const String& uri);
+
+  /**
+   * Called before the handler of route runs
+   */
+  void begin(size_t route);
+
+  /**
+   * Called after the handler returned, records the duration of the handler if it
+   * did not send a metered response
+   */
+  void end();
+
+  /**
+   * Records a completed response of the route, see MeteredResponse
+   */
+  void responded(size_t route, int code, size_t bytes, unsigned long durationMillis);
+
+  /**
+   * @return uri of the route, valid as long as the metrics exist
+   */
+  [[nodiscard]] const char* routeName(size_t route) const {
+    return m_routes[route].uri.c_str();
+  }
+
+  [[nodiscard]] size_t currentRoute() const {
+    return m_currentRoute;
+  }
+
+  [[nodiscard]] unsigned long currentStartMillis() const {
+    return m_currentStart;
+  }
+
+  /**
+   * Called when a metered response of route was created, see MeteredResponse
+   */
+  void started(size_t route) {
+    m_metered = true;
+    ++m_routes[route].inFlight;
+  }
+
+  /**
+   * Counts a request of route which was shed by the admission control
+   */
+  void rejected(size_t route) {
+    ++m_routes[route].rejected;
+  }
+
+  /**
+   * @return responses of route which were created but not yet destroyed
+   */
+  [[nodiscard]] uint32_t inFlight(size_t route) const {
+    return m_routes[route].inFlight;
+  }
+
+  [[nodiscard]] size_t routeCount() const {
+    return m_routeCount;
+  }
+
+  void sampleHeap();
+
+  struct RenderPosition {
+    size_t line = 0;
+    size_t offset = 0;
+    // a line split between two chunks is continued from the same text
+    size_t length = 0;
+    std::array<char, 160> text{};
+  };
+
+  /**
+   * Writes the metrics from position on into buffer, used as chunked response
+   * callback. Lines are formatted on demand, the text is never held in RAM.
+   * @return written bytes, 0 once all lines were written
+   */
+  size_t render(uint8_t* buffer, size_t maxLen, RenderPosition& position) const;
+
+ private:
+  static constexpr size_t s_codeClasses = 5;
+  static constexpr size_t s_buckets = s_latencyBucketsMs.size() + 1;
+
+  struct Route {
+    String uri;
+    uint32_t requests = 0;
+    uint32_t bytes = 0;
+    uint32_t durationSumMillis = 0;
+    uint32_t inFlight = 0;
+    uint32_t rejected = 0;
+    std::array<uint32_t, s_codeClasses> codes{};
+    std::array<uint32_t, s_buckets> buckets{};
+  };
+
+  /**
+   * @return length of the line, 0 for skipped lines, -1 after the last line
+   */
+  int formatLine(size_t line, char* out, size_t size) const;
+  int formatRouteLine(size_t family, size_t route, size_t sample, char* out, size_t size)
+    const;
+  static int formatPhaseLine(
+    size_t family,
+    const char* name,
+    size_t phase,
+    char* out,
+    size_t size);
+  void recordDuration(Route& route, unsigned long durationMillis);
+
+  std::array<Route, s_maxRoutes> m_routes{};
+  size_t m_routeCount = 0;
+  yal::Logger m_logger = yal::Logger("METRICS");
+
+  size_t m_currentRoute = 0;
+  unsigned long m_currentStart = 0;
+  bool m_metered = false;
+
+  uint32_t m_minFreeHeap = UINT32_MAX;
+};
+
+/**
+ * Forwards to the wrapped response and records code, sent bytes and the time until
+ * the response was destroyed, i.e. completely sent or aborted
+ */
+class MeteredResponse : public AsyncWebServerResponse {
+ public:
+  MeteredResponse(RequestMetrics& metrics, int code, AsyncWebServerResponse* response) :
+      m_metrics(metrics),
+      m_response(response),
+      m_route(metrics.currentRoute()),
+      m_code(code),
+      m_start(metrics.currentStartMillis()) {
+    metrics.started(m_route);
+  }
+
+  MeteredResponse(const MeteredResponse&) = delete;
+
+  ~MeteredResponse() override {
+    m_metrics.responded(m_route, m_code, m_bytes, millis() - m_start);
+    delete m_response;
+  }
+
+  void setCode(int code) override {
+    m_code = code;
+    m_response->setCode(code);
+  }
+
+  void setContentLength(size_t len) override {
+    m_response->setContentLength(len);
+  }
+
+  void addHeader(const String& name, const String& value) override {
+    m_response->addHeader(name, value);
+  }
+
+  String _assembleHead(uint8_t version) override {
+    return m_response->_assembleHead(version);
+  }
+
+  bool _started() const override {
+    return m_response->_started();
+  }
+
+  bool _finished() const override {
+    return m_response->_finished();
+  }
+
+  bool _failed() const override {
+    return m_response->_failed();
+  }
+
+  bool _sourceValid() const override {
+    return m_response->_sourceValid();
+  }
+
+  void _respond(AsyncWebServerRequest* request) override {
+    m_response->_respond(request);
+  }
+
+  size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override {
+    m_bytes += len;
+    return m_response->_ack(request, len, time);
+  }
+
+ private:
+  RequestMetrics& m_metrics;
+  AsyncWebServerResponse* const m_response;
+  const size_t m_route;
+  int m_code;
+  const unsigned long m_start;
+  size_t m_bytes = 0;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_REQUESTMETRICS_HPP
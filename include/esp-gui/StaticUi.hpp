@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_STATICUI_HPP
+#define ESP_GUI_STATICUI_HPP
+
+#include <Arduino.h>
+
+#include <esp-gui/ElementType.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Containers which are known at compile time. The page bytes and the element table
+ * are built by the compiler and placed in flash, nothing is generated or written to
+ * the file system at boot:
+ *
+ *   static constexpr auto s_ui PROGMEM = esp_gui::ui::page(
+ *     esp_gui::ui::container(
+ *       "Settings",
+ *       esp_gui::ui::input<esp_gui::InputElementType::INT>("Interval", "interval"),
+ *       esp_gui::ui::button("Restart sensor", "restart_sensor")));
+ *
+ *   server.setStaticUi(esp_gui::ui::view(s_ui));
+ *
+ * The markup is the same as the one of the runtime elements. Lists, dropdowns and
+ * uploads need runtime state and are added with WebServer::addContainer().
+ */
+namespace esp_gui::ui {
+
+/**
+ * Element table entry, the config name is stored in the name blob of the page
+ */
+struct Entry {
+  uint16_t nameOffset;
+  uint8_t nameLength;
+  // index of the container
+  uint8_t panel;
+  ElementType type;
+};
+
+/**
+ * Location of a container and its title in the page markup
+ */
+struct Panel {
+  uint16_t htmlOffset;
+  uint16_t htmlLength;
+  uint16_t titleOffset;
+  uint8_t titleLength;
+};
+
+template<size_t N>
+struct Text {
+  std::array<char, N + 1> data{};
+};
+
+template<size_t N>
+constexpr Text<N - 1> literal(const char (&value)[N]) {
+  Text<N - 1> result{};
+  for (size_t i = 0; i + 1 < N; ++i) {
+    result.data[i] = value[i];
+  }
+  return result;
+}
+
+template<size_t A, size_t B>
+constexpr Text<A + B> operator+(const Text<A>& lhs, const Text<B>& rhs) {
+  Text<A + B> result{};
+  for (size_t i = 0; i < A; ++i) {
+    result.data[i] = lhs.data[i];
+  }
+  for (size_t i = 0; i < B; ++i) {
+    result.data[A + i] = rhs.data[i];
+  }
+  return result;
+}
+
+/**
+ * Markup, config names, element table and containers of a part of the page
+ */
+template<size_t H, size_t N, size_t E, size_t P>
+struct Fragment {
+  Text<H> html;
+  Text<N> names;
+  std::array<Entry, E> entries{};
+  std::array<Panel, P> panels{};
+};
+
+template<
+  size_t H1,
+  size_t N1,
+  size_t E1,
+  size_t P1,
+  size_t H2,
+  size_t N2,
+  size_t E2,
+  size_t P2>
+constexpr Fragment<H1 + H2, N1 + N2, E1 + E2, P1 + P2> operator+(
+  const Fragment<H1, N1, E1, P1>& lhs,
+  const Fragment<H2, N2, E2, P2>& rhs) {
+  Fragment<H1 + H2, N1 + N2, E1 + E2, P1 + P2> result{};
+  result.html = lhs.html + rhs.html;
+  result.names = lhs.names + rhs.names;
+  for (size_t i = 0; i < E1; ++i) {
+    result.entries[i] = lhs.entries[i];
+  }
+  for (size_t i = 0; i < E2; ++i) {
+    auto entry = rhs.entries[i];
+    entry.nameOffset = static_cast<uint16_t>(entry.nameOffset + N1);
+    entry.panel = static_cast<uint8_t>(entry.panel + P1);
+    result.entries[E1 + i] = entry;
+  }
+  for (size_t i = 0; i < P1; ++i) {
+    result.panels[i] = lhs.panels[i];
+  }
+  for (size_t i = 0; i < P2; ++i) {
+    auto panel = rhs.panels[i];
+    panel.htmlOffset = static_cast<uint16_t>(panel.htmlOffset + H1);
+    panel.titleOffset = static_cast<uint16_t>(panel.titleOffset + H1);
+    result.panels[P1 + i] = panel;
+  }
+  return result;
+}
+
+namespace detail {
+
+template<size_t N>
+constexpr Fragment<N, 0, 0, 0> markup(const Text<N>& html) {
+  Fragment<N, 0, 0, 0> result{};
+  result.html = html;
+  return result;
+}
+
+template<ElementType Type, size_t N>
+constexpr Fragment<0, N - 1, 1, 0> entry(const char (&configName)[N]) {
+  static_assert(N - 1 <= UINT8_MAX, "config name too long");
+  Fragment<0, N - 1, 1, 0> result{};
+  result.names = literal(configName);
+  result.entries[0] = {0, static_cast<uint8_t>(N - 1), 0, Type};
+  return result;
+}
+
+/**
+ * Marks content as one container, its elements belong to it
+ */
+template<size_t H, size_t N, size_t E>
+constexpr Fragment<H, N, E, 1> panel(
+  const Fragment<H, N, E, 0>& content,
+  size_t titleOffset,
+  size_t titleLength) {
+  Fragment<H, N, E, 1> result{};
+  result.html = content.html;
+  result.names = content.names;
+  result.entries = content.entries;
+  result.panels[0] = {
+    0,
+    static_cast<uint16_t>(H),
+    static_cast<uint16_t>(titleOffset),
+    static_cast<uint8_t>(titleLength)};
+  return result;
+}
+
+template<InputElementType Type>
+constexpr auto inputType() {
+  if constexpr (Type == InputElementType::PASSWORD) {
+    return literal("password");
+  } else if constexpr (
+    Type == InputElementType::INT || Type == InputElementType::DOUBLE) {
+    return literal("number");
+  } else {
+    return literal("text");
+  }
+}
+
+template<InputElementType Type>
+constexpr ElementType elementType() {
+  switch (Type) {
+    case InputElementType::PASSWORD:
+      return ElementType::PASSWORD;
+    case InputElementType::INT:
+      return ElementType::INT;
+    case InputElementType::DOUBLE:
+      return ElementType::DOUBLE;
+    case InputElementType::STRING:
+    default:
+      return ElementType::STRING;
+  }
+}
+
+}  // namespace detail
+
+template<InputElementType Type, size_t L, size_t C>
+constexpr auto input(const char (&label)[L], const char (&configName)[C]) {
+  const auto id = literal(configName);
+  // clang-format off
+  const auto html =
+    literal("<label for=\"") + id + literal("\">") + literal(label) + literal("</label>"
+    "<input id=\"") + id + literal(R"(" class="inputLarge")"
+      "name=\"") + id + literal("\" "
+      "value=\"%") + id + literal("%\" "
+      "type=\"") + detail::inputType<Type>() + literal("\" "
+      "form=\"formUpdateConfig\" "
+      "/>"
+    "<br/>");
+  // clang-format on
+  return detail::markup(html) + detail::entry<detail::elementType<Type>()>(configName);
+}
+
+/**
+ * The click handler is registered with WebServer::onStaticButton()
+ */
+template<size_t L, size_t C>
+constexpr auto button(const char (&label)[L], const char (&configName)[C]) {
+  const auto id = literal(configName);
+  // clang-format off
+  const auto html =
+    literal("<label for=\"") + id + literal("\"></label>"
+    "<input id=\"") + id + literal(R"(" class="btn btnFlexContainer otherLarge")"
+      "name=\"") + id + literal("\" "
+      "value=\"") + literal(label) + literal("\" "
+      "form=\"formOnClick\" "
+      "type=\"submit\" "
+      "/>"
+    "<br/>");
+  // clang-format on
+  return detail::markup(html) + detail::entry<ElementType::BUTTON>(configName);
+}
+
+template<size_t T, typename... Elements>
+constexpr auto container(const char (&title)[T], const Elements&... elements) {
+  static_assert(T - 1 <= UINT8_MAX, "title too long");
+  const auto hero = literal(R"(<div class="flex-card"><div class="hero"><h3>)");
+  const auto start =
+    hero + literal(title) + literal(R"(</h3></div><div class="content">)");
+  const auto content = detail::markup(start) +
+    (elements + ... + detail::markup(literal("</div></div>")));
+  return detail::panel(content, hero.data.size() - 1, T - 1);
+}
+
+template<typename... Containers>
+constexpr auto page(const Containers&... containers) {
+  const auto result = (containers + ... + Fragment<0, 0, 0, 0>{});
+  static_assert(sizeof(result.html.data) <= UINT16_MAX, "static ui too large");
+  static_assert(sizeof...(Containers) <= UINT8_MAX, "too many containers");
+  return result;
+}
+
+/**
+ * Location of a page in flash, the bytes are only accessed with the _P functions
+ */
+struct StaticUi {
+  PGM_P html = nullptr;
+  size_t htmlLength = 0;
+  PGM_P names = nullptr;
+  const Entry* entries = nullptr;
+  size_t entryCount = 0;
+  const Panel* panels = nullptr;
+  size_t panelCount = 0;
+};
+
+template<size_t H, size_t N, size_t E, size_t P>
+StaticUi view(const Fragment<H, N, E, P>& page) {
+  return {
+    page.html.data.data(),
+    H,
+    page.names.data.data(),
+    page.entries.data(),
+    E,
+    page.panels.data(),
+    P};
+}
+
+}  // namespace esp_gui::ui
+
+#endif  // ESP_GUI_STATICUI_HPP
@@ -6,31 +6,57 @@
 #ifndef ESP_GUI_UPDATEMANAGER_H
 #define ESP_GUI_UPDATEMANAGER_H
 #include "ESPAsyncWebServer.h"
+#include <esp-gui/DeltaStage.hpp>
+#include <esp-gui/UploadStages.hpp>
 #include <esp-gui/WebServer.hpp>
 #include <yal/yal.hpp>
+#include <array>
+#include <memory>
 namespace esp_gui {
 class UpdateManager {
  public:
   UpdateManager(WebServer& webServer) :
-      m_logger(yal::Logger("UPDATE")), m_webServer(webServer) {
+      m_logger(yal::Logger("UPDATE")),
+      m_webServer(webServer),
+      m_pipeline(std::make_shared<UploadPipeline>()),
+      m_deltaPipeline(std::make_shared<UploadPipeline>()),
+      m_fileSystemPipeline(std::make_shared<UploadPipeline>()) {
   }
   void setup();
 
- private:
-  void onPost(AsyncWebServerRequest* request);
+  /**
+   * Writes buffered update data to flash, has to be called from the main loop
+   */
+  void loop();
 
-  void onUpload(
-    AsyncWebServerRequest* request,
-    const String& filename,
-    size_t index,
-    uint8_t* data,
-    size_t len,
-    bool final);
+ private:
+  void onPost(AsyncWebServerRequest* request, UploadPipeline& pipeline);
+  void onFileSystemPost(AsyncWebServerRequest* request);
+  void onProgress(AsyncWebServerRequest* request);
+  [[nodiscard]] const OtaPipeline& activeOta() const;
 
   yal::Logger m_logger;
   WebServer& m_webServer;
 
-  static inline const String m_uploadConfigName = "updateFirmware";
+  // expected size and digests are read from the X-Update-* headers or the
+  // size, md5 and sha256 form fields sent before the file
+  std::shared_ptr<UploadPipeline> m_pipeline;
+  const OtaSink* m_sink = nullptr;
+
+  // patch against the running firmware, size and digests describe the result
+  std::shared_ptr<UploadPipeline> m_deltaPipeline;
+  const OtaSink* m_deltaSink = nullptr;
+
+  // littlefs image, configuration and html index are reloaded afterwards
+  std::shared_ptr<UploadPipeline> m_fileSystemPipeline;
+  const OtaSink* m_fileSystemSink = nullptr;
+  OtaPipeline::State m_fileSystemState = OtaPipeline::State::IDLE;
+
+  // still applying a patch after the upload was posted
+  const UploadPipeline* m_pendingPipeline = nullptr;
+
+  static constexpr int HTTP_OK = 200;
+  static constexpr int HTTP_BAD_REQUEST = 400;
 };
 
 }  // namespace esp_gui
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_UPLOADPIPELINE_HPP
+#define ESP_GUI_UPLOADPIPELINE_HPP
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <yal/yal.hpp>
+#include <memory>
+#include <vector>
+
+namespace esp_gui {
+
+/**
+ * Part of an UploadPipeline. Stages transform or check the data and forward it to
+ * the next stage. The last stage is the sink which stores the data.
+ */
+class UploadStage {
+ public:
+  virtual ~UploadStage() = default;
+
+  virtual bool begin(AsyncWebServerRequest* request, const String& filename) {
+    return m_next == nullptr || m_next->begin(request, filename);
+  }
+
+  virtual bool write(const uint8_t* data, size_t len) {
+    return m_next == nullptr || m_next->write(data, len);
+  }
+
+  virtual bool end() {
+    return m_next == nullptr || m_next->end();
+  }
+
+  virtual void abort() {
+    if (m_next != nullptr) {
+      m_next->abort();
+    }
+  }
+
+  /**
+   * Called before abort() if the client went away, the connection must not be used
+   */
+  virtual void disconnected() {
+    if (m_next != nullptr) {
+      m_next->disconnected();
+    }
+  }
+
+  virtual void loop() {
+    if (m_next != nullptr) {
+      m_next->loop();
+    }
+  }
+
+  /**
+   * @return true while a stage still processes data after the upload ended
+   */
+  [[nodiscard]] virtual bool busy() const {
+    return m_next != nullptr && m_next->busy();
+  }
+
+  /**
+   * @return first error of this or any following stage, nullptr if there is none
+   */
+  [[nodiscard]] const char* error() const {
+    if (m_error != nullptr || m_next == nullptr) {
+      return m_error;
+    }
+    return m_next->error();
+  }
+
+ protected:
+  void setError(const char* error) {
+    m_error = error;
+  }
+
+ private:
+  friend class UploadPipeline;
+  UploadStage* m_next = nullptr;
+  const char* m_error = nullptr;
+};
+
+/**
+ * Chains upload stages and drives them from the upload handler of the web server.
+ * Each stage only sees the current chunk, memory usage does not depend on the
+ * file size.
+ */
+class UploadPipeline {
+ public:
+  UploadPipeline() : m_logger(yal::Logger("UPLOAD")) {
+  }
+
+  UploadPipeline(const UploadPipeline&) = delete;
+
+  /**
+   * Appends a stage, data flows through the stages in the order they were added
+   */
+  template<typename T, typename... Args>
+  T& add(Args&&... args) {
+    auto stage = std::make_unique<T>(std::forward<Args>(args)...);
+    T& result = *stage;
+    if (!m_stages.empty()) {
+      m_stages.back()->m_next = stage.get();
+    }
+    m_stages.push_back(std::move(stage));
+    return result;
+  }
+
+  void onUpload(
+    AsyncWebServerRequest* request,
+    const String& filename,
+    size_t index,
+    uint8_t* data,
+    size_t len,
+    bool final);
+
+  void loop();
+
+  /**
+   * @return true once all data was received and no stage is still working on it
+   */
+  [[nodiscard]] bool succeeded() const {
+    return m_state == State::FINISHED && !busy() && error() == nullptr;
+  }
+
+  [[nodiscard]] bool busy() const {
+    return m_state == State::FINISHED && m_stages.front()->busy();
+  }
+
+  [[nodiscard]] const char* error() const;
+
+  /**
+   * Reads a value from the request header or a form field sent before the file
+   */
+  static String requestValue(
+    AsyncWebServerRequest* request,
+    const String& header,
+    const char* field);
+
+ private:
+  enum class State { IDLE, RECEIVING, FINISHED, FAILED };
+
+  void fail(AsyncWebServerRequest* request, bool closeConnection);
+
+  yal::Logger m_logger;
+  std::vector<std::unique_ptr<UploadStage>> m_stages;
+  State m_state = State::IDLE;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_UPLOADPIPELINE_HPP
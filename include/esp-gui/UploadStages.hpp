@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_UPLOADSTAGES_HPP
+#define ESP_GUI_UPLOADSTAGES_HPP
+
+#include <esp-gui/Configuration.hpp>
+#include <esp-gui/ImageVerifier.hpp>
+#include <esp-gui/OtaPipeline.hpp>
+#include <esp-gui/UploadPipeline.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+
+namespace esp_gui {
+
+/**
+ * Fails the upload as soon as more than maxSize bytes were received
+ */
+class SizeLimitStage : public UploadStage {
+ public:
+  explicit SizeLimitStage(size_t maxSize) : m_maxSize(maxSize) {
+  }
+
+  bool begin(AsyncWebServerRequest* request, const String& filename) override;
+  bool write(const uint8_t* data, size_t len) override;
+
+ private:
+  const size_t m_maxSize;
+  size_t m_size = 0;
+};
+
+/**
+ * Verifies size and digests announced by the client.
+ * Reads <prefix>Size, <prefix>MD5 and <prefix>SHA256 headers or the form fields
+ * size, md5 and sha256.
+ */
+class DigestStage : public UploadStage {
+ public:
+  explicit DigestStage(const char* headerPrefix = "X-Update-") :
+      m_headerPrefix(headerPrefix) {
+  }
+
+  bool begin(AsyncWebServerRequest* request, const String& filename) override;
+  bool write(const uint8_t* data, size_t len) override;
+  bool end() override;
+
+ private:
+  const char* const m_headerPrefix;
+  ImageVerifier m_verifier;
+};
+
+/**
+ * Checks the magic bytes and compression method of a gzip stream. Nothing is
+ * inflated, the data is forwarded compressed. A FileSink stores it as .gz, which the
+ * web server serves with the matching content encoding. The OtaSink rejects it.
+ */
+class GzipMagicStage : public UploadStage {
+ public:
+  bool begin(AsyncWebServerRequest* request, const String& filename) override;
+  bool write(const uint8_t* data, size_t len) override;
+
+ private:
+  std::array<uint8_t, 3> m_header{};
+  size_t m_headerSize = 0;
+};
+
+/**
+ * Writes the upload into the firmware (U_FLASH) or filesystem (U_FS) partition.
+ * Throttling holds back tcp acks and is only correct if the sink receives the
+ * bytes of the connection, disable it behind stages which produce data.
+ * Gzip compressed images are rejected, they would be flashed as they are.
+ */
+class OtaSink : public UploadStage {
+ public:
+  explicit OtaSink(int command, bool throttle = true) :
+      m_command(command), m_throttle(throttle) {
+  }
+
+  bool begin(AsyncWebServerRequest* request, const String& filename) override;
+  bool write(const uint8_t* data, size_t len) override;
+  bool end() override;
+  void abort() override;
+  void disconnected() override;
+  void loop() override;
+
+  [[nodiscard]] const OtaPipeline& ota() const {
+    return m_ota;
+  }
+
+ private:
+  const int m_command;
+  const bool m_throttle;
+  OtaPipeline m_ota;
+  std::array<uint8_t, 2> m_magic{};
+  size_t m_magicSize = 0;
+};
+
+/**
+ * Writes the upload to a temporary file which replaces path once the upload is
+ * complete. Gzip compressed uploads are stored as path.gz.
+ */
+class FileSink : public UploadStage {
+ public:
+  explicit FileSink(String path) : m_path(std::move(path)) {
+  }
+
+  bool begin(AsyncWebServerRequest* request, const String& filename) override;
+  bool write(const uint8_t* data, size_t len) override;
+  bool end() override;
+  void abort() override;
+
+ private:
+  const String m_path;
+  // the file handle keeps a pointer to the name
+  String m_tempPath;
+  std::unique_ptr<Configuration::FileHandle> m_file;
+  std::array<uint8_t, 2> m_magic{};
+  size_t m_size = 0;
+};
+
+/**
+ * Passes the data to a user callback, returning false fails the upload
+ */
+class CallbackSink : public UploadStage {
+ public:
+  using OnData = std::function<bool(const uint8_t* data, size_t len)>;
+
+  explicit CallbackSink(OnData&& onData) : m_onData(std::move(onData)) {
+  }
+
+  bool write(const uint8_t* data, size_t len) override;
+
+ private:
+  OnData m_onData;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_UPLOADSTAGES_HPP
@@ -6,6 +6,7 @@
 #ifndef ESP_GUI_UTIL_HPP
 #define ESP_GUI_UTIL_HPP
 
+#include <Arduino.h>
 #include <yal/yal.hpp>
 
 void logMemory(const yal::Logger& logger);
@@ -10,22 +10,33 @@
 
 #include "Configuration.hpp"
 #include <ESPAsyncWebServer.h>
+#include <esp-gui/AdmissionControl.hpp>
+#include <esp-gui/ElementType.hpp>
+#include <esp-gui/FlashPage.hpp>
+#include <esp-gui/FlashString.hpp>
+#include <esp-gui/PageSource.hpp>
+#include <esp-gui/RequestMetrics.hpp>
+#include <esp-gui/StaticUi.hpp>
+#include <esp-gui/UploadPipeline.hpp>
 #include <esp-gui/Util.hpp>
 #include <yal/yal.hpp>
 #include <any>
 #include <chrono>
+#include <memory>
+#include <optional>
 #include <utility>
 
 namespace esp_gui {
 
 using std::chrono_literals::operator""s;
 
-enum class InputElementType { STRING, PASSWORD, INT, DOUBLE };
-enum class ElementType { STRING, PASSWORD, INT, DOUBLE, LIST, BUTTON, UPLOAD, DROPDOWN };
-
 class Element {
  public:
-  Element(ElementType type, String label, String configName, bool isReadOnly = false) :
+  Element(
+    ElementType type,
+    FlashString label,
+    FlashString configName,
+    bool isReadOnly = false) :
       m_type(type),
       m_label(std::move(label)),
       m_configName(std::move(configName)),
@@ -34,11 +45,11 @@ class Element {
 
   virtual ~Element() = default;
 
-  [[nodiscard]] const String& label() const {
+  [[nodiscard]] const FlashString& label() const {
     return m_label;
   }
 
-  [[nodiscard]] const String& configName() const {
+  [[nodiscard]] const FlashString& configName() const {
     return m_configName;
   }
 
@@ -52,8 +63,8 @@ class Element {
 
  private:
   const ElementType m_type;
-  const String m_label;
-  const String m_configName;
+  const FlashString m_label;
+  const FlashString m_configName;
   const bool m_readOnly;
 };
 
@@ -61,8 +72,8 @@ class InputElement : public Element {
  public:
   InputElement(
     InputElementType type,
-    String label,
-    String configName,
+    FlashString label,
+    FlashString configName,
     bool isReadOnly = false) :
       Element(convert(type), std::move(label), std::move(configName), isReadOnly) {
   }
@@ -86,50 +97,70 @@ class InputElement : public Element {
 class ChoiceElementBase : public Element {
  public:
   ChoiceElementBase(
-    std::vector<String>&& options,
+    std::vector<FlashString>&& options,
     ElementType type,
-    String label,
-    String configName,
-    bool isReadOnly = false) :
+    FlashString label,
+    FlashString configName,
+    bool isReadOnly = false,
+    OptionLoading loading = OptionLoading::INLINE) :
       Element(type, std::move(label), std::move(configName), isReadOnly),
-      m_options(std::move(options)) {
+      m_options(std::move(options)),
+      m_loading(loading) {
   }
 
   ~ChoiceElementBase() override = default;
 
-  void addOption(const String& option) {
-    m_options.push_back(option);
+  void addOption(FlashString option) {
+    m_options.push_back(std::move(option));
+    ++s_optionsVersion;
   }
 
   void clearOptions() {
     m_options.clear();
+    ++s_optionsVersion;
   }
 
-  void setOptions(std::vector<String>&& options) {
-    m_options = options;
+  void setOptions(std::vector<FlashString>&& options) {
+    m_options = std::move(options);
+    ++s_optionsVersion;
   }
 
-  [[nodiscard]] const std::vector<String>& options() const {
+  [[nodiscard]] const std::vector<FlashString>& options() const {
     return m_options;
   }
 
+  [[nodiscard]] OptionLoading loading() const {
+    return m_loading;
+  }
+
+  /**
+   * @return counter which is increased whenever the options of any element change
+   */
+  [[nodiscard]] static uint32_t optionsVersion() {
+    return s_optionsVersion;
+  }
+
  private:
-  std::vector<String> m_options;
+  std::vector<FlashString> m_options;
+  const OptionLoading m_loading;
+  static inline uint32_t s_optionsVersion = 0;
 };
 
 class ListElement : public ChoiceElementBase {
  public:
   ListElement(
-    std::vector<String>&& options,
-    String label,
-    String configName,
-    bool isReadOnly = false) :
+    std::vector<FlashString>&& options,
+    FlashString label,
+    FlashString configName,
+    bool isReadOnly = false,
+    OptionLoading loading = OptionLoading::INLINE) :
       ChoiceElementBase(
         std::move(options),
         ElementType::LIST,
         std::move(label),
         std::move(configName),
-        isReadOnly) {
+        isReadOnly,
+        loading) {
   }
 };
 
@@ -137,16 +168,18 @@ class DropDownElement : public ChoiceElementBase {
  public:
  public:
   DropDownElement(
-    std::vector<String>&& options,
-    String label,
-    String configName,
-    bool isReadOnly = false) :
+    std::vector<FlashString>&& options,
+    FlashString label,
+    FlashString configName,
+    bool isReadOnly = false,
+    OptionLoading loading = OptionLoading::INLINE) :
       ChoiceElementBase(
         std::move(options),
         ElementType::DROPDOWN,
         std::move(label),
         std::move(configName),
-        isReadOnly) {
+        isReadOnly,
+        loading) {
   }
 };
 
@@ -155,8 +188,8 @@ class ButtonElement : public Element {
   using OnClick = std::function<void()>;
 
   ButtonElement(
-    String label,
-    String configName,
+    FlashString label,
+    FlashString configName,
     OnClick&& onClick,
     std::chrono::seconds delayBeforeRedirect = 0s) :
       Element(ElementType::BUTTON, std::move(label), std::move(configName), true),
@@ -186,10 +219,10 @@ class UploadElement : public Element {
   using OnPost = std::function<void(AsyncWebServerRequest* request)>;
 
   UploadElement(
-    String browseLabel,
-    String buttonLabel,
-    String configName,
-    String acceptedFiles,
+    FlashString browseLabel,
+    FlashString buttonLabel,
+    FlashString configName,
+    FlashString acceptedFiles,
     OnUpload&& onUpload,
     OnPost&& onPost) :
       Element(ElementType::UPLOAD, std::move(buttonLabel), std::move(configName), true),
@@ -215,27 +248,27 @@ class UploadElement : public Element {
     m_onPost(request);
   }
 
-  [[nodiscard]] const String& acceptedFiles() const {
+  [[nodiscard]] const FlashString& acceptedFiles() const {
     return m_acceptedFiles;
   }
 
-  [[nodiscard]] const String& browseLabel() const {
+  [[nodiscard]] const FlashString& browseLabel() const {
     return m_browseLabel;
   }
 
  private:
-  String m_browseLabel;
-  String m_acceptedFiles;
+  FlashString m_browseLabel;
+  FlashString m_acceptedFiles;
   OnUpload m_onUpload;
   OnPost m_onPost;
 };
 
 class Container {
  public:
-  explicit Container(String title) : m_title(std::move(title)), m_elements({}) {
+  explicit Container(FlashString title) : m_title(std::move(title)), m_elements({}) {
   }
 
-  [[nodiscard]] const String& title() const {
+  [[nodiscard]] const FlashString& title() const {
     return m_title;
   }
 
@@ -244,26 +277,36 @@ class Container {
   }
 
   void addList(
-    std::vector<String>&& options,
-    String label,
-    String configName,
-    bool isReadOnly = false) {
+    std::vector<FlashString>&& options,
+    FlashString label,
+    FlashString configName,
+    bool isReadOnly = false,
+    OptionLoading loading = OptionLoading::INLINE) {
     m_elements.emplace_back(ListElement(
-      std::move(options), std::move(label), std::move(configName), isReadOnly));
+      std::move(options),
+      std::move(label),
+      std::move(configName),
+      isReadOnly,
+      loading));
   }
 
   void addDropdown(
-    std::vector<String>&& options,
-    String label,
-    String configName,
-    bool isReadOnly = false) {
+    std::vector<FlashString>&& options,
+    FlashString label,
+    FlashString configName,
+    bool isReadOnly = false,
+    OptionLoading loading = OptionLoading::INLINE) {
     m_elements.emplace_back(DropDownElement(
-      std::move(options), std::move(label), std::move(configName), isReadOnly));
+      std::move(options),
+      std::move(label),
+      std::move(configName),
+      isReadOnly,
+      loading));
   }
 
   void addButton(
-    String label,
-    String configName,
+    FlashString label,
+    FlashString configName,
     ButtonElement::OnClick&& onClick,
     std::chrono::seconds delayBeforeRedirect = 0s) {
     m_elements.emplace_back(ButtonElement(
@@ -272,18 +315,18 @@ class Container {
 
   void addInput(
     InputElementType type,
-    String label,
-    String configName,
+    FlashString label,
+    FlashString configName,
     bool isReadOnly = false) {
     m_elements.emplace_back(
       InputElement(type, std::move(label), std::move(configName), isReadOnly));
   }
 
   void addUpload(
-    String browseLabel,
-    String buttonLabel,
-    String configName,
-    String acceptedFiles,
+    FlashString browseLabel,
+    FlashString buttonLabel,
+    FlashString configName,
+    FlashString acceptedFiles,
     UploadElement::OnUpload&& onUpload,
     UploadElement::OnPost&& onPost) {
     m_elements.emplace_back(UploadElement(
@@ -295,15 +338,53 @@ class Container {
       std::move(onPost)));
   }
 
+  /**
+   * Streams the uploaded file through the pipeline, onPost is called once the
+   * upload is complete and can check pipeline->succeeded()
+   */
+  void addUpload(
+    FlashString browseLabel,
+    FlashString buttonLabel,
+    FlashString configName,
+    FlashString acceptedFiles,
+    std::shared_ptr<UploadPipeline> pipeline,
+    UploadElement::OnPost&& onPost) {
+    addUpload(
+      std::move(browseLabel),
+      std::move(buttonLabel),
+      std::move(configName),
+      std::move(acceptedFiles),
+      [pipeline](
+        AsyncWebServerRequest* request,
+        const String& filename,
+        size_t index,
+        uint8_t* data,
+        size_t len,
+        bool final) { pipeline->onUpload(request, filename, index, data, len, final); },
+      std::move(onPost));
+  }
+
  private:
-  const String m_title;
+  const FlashString m_title;
   std::vector<std::any> m_elements;
 };
 
 class WebServer {
  public:
+  /**
+   * FILE_SYSTEM keeps the runtime containers and a rendered copy of the page in
+   * LittleFS. FLASH streams the page straight from flash and keeps the runtime
+   * containers in ram, the web interface does not need a file system then.
+   */
+  enum class PageStorage { FILE_SYSTEM, FLASH };
+
+  using ValueCheck = std::function<bool(JsonVariantConst value)>;
+
   WebServer(int port, const char* const hostname, Configuration& config) :
       m_asyncWebServer(AsyncWebServer(port)), m_hostname(hostname), m_config(config) {
+    addConfigKey(s_pageTitleKey, [](JsonVariantConst value) {
+      return value.is<const char*>();
+    });
   }
 
   WebServer(const WebServer&) = delete;
@@ -311,26 +392,106 @@ class WebServer {
   void setup(const String& hostname);
 
   void setPageTitle(const String& title) {
-    m_config.setValue("page_title", title);
+    m_config.setValue(s_pageTitleKey, title);
+  }
+
+  /**
+   * Lets /config/import set a key which is not held by an element,
+   * check validates the imported value. A secret key is left out of
+   * /config/export unless the export asks for secrets.
+   */
+  void addConfigKey(const String& key, ValueCheck&& check, bool secret = false) {
+    m_configKeys.push_back({key, std::move(check), secret});
   }
 
   void addContainer(Container&& container);
 
+  /**
+   * Has to be called before setup()
+   */
+  void setPageStorage(PageStorage storage) {
+    m_pageStorage = storage;
+  }
+
+  /**
+   * With FILE_SYSTEM storage the rendered page is written to LittleFS on the first
+   * view after a change. Every rewrite erases flash, so rewrites are at least
+   * interval apart. Views in between render the page for each request.
+   * A zero interval disables the rendered copy, nothing is written for a view then.
+   */
+  void setPageCacheInterval(std::chrono::milliseconds interval) {
+    m_pageCacheInterval = interval;
+  }
+
+  /**
+   * Places the containers of a page built at compile time, see StaticUi.hpp, before
+   * the containers added at runtime. Has to be called before setup().
+   */
+  void setStaticUi(const ui::StaticUi& staticUi) {
+    m_staticUi = staticUi;
+  }
+
+  /**
+   * Registers the click handler of a button of the static ui before setup()
+   * @return false if the static ui has no button with this name
+   */
+  bool onStaticButton(
+    FlashString configName,
+    ButtonElement::OnClick&& onClick,
+    std::chrono::seconds delayBeforeRedirect = 0s);
+
+  /**
+   * Registers an additional route, for endpoints outside of the generated page
+   */
+  void on(
+    const char* uri,
+    WebRequestMethodComposite method,
+    ArRequestHandlerFunction&& handler,
+    AdmissionControl::RouteClass routeClass = AdmissionControl::RouteClass::PAGE);
+
   template<typename T>
   T* findElement(const String& key) {
-    const auto iter = m_elementMap.find(key);
-    if (iter == m_elementMap.end()) {
+    auto* any = findAny(key);
+    if (any == nullptr) {
       return nullptr;
     }
-    return std::any_cast<T>(iter->second);
+    return std::any_cast<T>(any);
   }
 
   void redirectBackToHome(
     AsyncWebServerRequest* request,
-    const std::chrono::seconds& delay);
+    const std::chrono::seconds& delay,
+    const String& location = "/");
 
   void reset(AsyncWebServerRequest* request, const char* reason);
 
+  /**
+   * Sends the response and records its code, size and duration in the metrics
+   */
+  void send(AsyncWebServerRequest* request, int code, AsyncWebServerResponse* response);
+  void send(
+    AsyncWebServerRequest* request,
+    int code,
+    const String& contentType,
+    const String& content);
+
+  [[nodiscard]] RequestMetrics& metrics() {
+    return m_metrics;
+  }
+
+  /**
+   * Limits and heap thresholds have to be configured before setup()
+   */
+  [[nodiscard]] AdmissionControl& admission() {
+    return m_admission;
+  }
+
+  /**
+   * Reloads configuration and rewrites the html index if it does not match the
+   * containers, used after the file system image was replaced
+   */
+  bool reloadFileSystem();
+
  private:
   AsyncWebServer m_asyncWebServer;
 
@@ -339,12 +500,81 @@ class WebServer {
   Configuration& m_config;
 
   std::vector<Container> m_container;
-  std::map<String, std::any*> m_elementMap;
+  ui::StaticUi m_staticUi;
+  // elements of the static ui which need runtime state, they are not rendered
+  Container m_staticElements{FlashString("")};
+
+  struct ElementEntry {
+    const Element* element;
+    std::any* any;
+  };
+
+  // sorted by config name, the names are not copied and may stay in flash
+  std::vector<ElementEntry> m_elementMap;
+
+  struct ConfigKey {
+    String key;
+    ValueCheck check;
+    bool secret;
+  };
+
+  // importable keys without element
+  std::vector<ConfigKey> m_configKeys;
+  static inline const char* const s_pageTitleKey = "page_title";
+  RequestMetrics m_metrics;
+  AdmissionControl m_admission;
+  size_t m_rootRoute = 0;
 
   static inline const String m_optionSuffix = "___list";
 
-  const String m_htmlIndex = "/index.html";
+  // only holds the containers added at runtime, the rest of the page is in flash
+  const String m_htmlIndex = "/index.runtime.html";
+
+  // containers are panels, the static ones first, each has its own page
+  static constexpr size_t s_allPanels = SIZE_MAX;
+  static inline const char* const s_panelField = "__panel";
+  static inline const char* const s_panelNavTemplate = "panel_nav";
+
+  struct FileRange {
+    size_t offset;
+    size_t length;
+  };
+
+  // runtime containers in the html index or in m_runtimeHtml
+  std::vector<FileRange> m_panelRanges;
+
+  PageStorage m_pageStorage = PageStorage::FILE_SYSTEM;
+  FlashPage m_flashPage;
+  std::string m_runtimeHtml;
+  enum FlashRegion : size_t {
+    REGION_START,
+    REGION_STATIC_UI,
+    REGION_RUNTIME,
+    REGION_PANEL_FIELD,
+    REGION_END
+  };
+  const String m_htmlCache = "/index.cache.html";
+
+  struct PageVersion {
+    uint32_t config = 0;
+    uint32_t options = 0;
+    uint32_t index = 0;
+
+    bool operator==(const PageVersion& other) const {
+      return config == other.config && options == other.options && index == other.index;
+    }
+  };
+
+  // the boot id keeps etags of different boots apart, the versions restart at 0
+  const uint32_t m_bootId = RANDOM_REG32;
+  uint32_t m_indexVersion = 0;
+  PageVersion m_cachedPage;
+  bool m_pageCacheValid = false;
+  std::chrono::milliseconds m_pageCacheInterval = 60s;
+  std::optional<unsigned long> m_pageCacheMillis;
   static inline const char* const s_redirectDelayedURL = "/delay";
+  static constexpr long s_defaultOptionLimit = 20;
+  static constexpr long s_maxOptionLimit = 50;
 
   std::chrono::seconds m_redirectDelay = 15s;
 
@@ -352,8 +582,12 @@ class WebServer {
   enum HtmlReturnCode {
     HTTP_OK = 200,
     HTTP_FOUND = 302,
+    HTTP_NOT_MODIFIED = 304,
+    HTTP_BAD_REQUEST = 400,
     HTTP_DENIED = 403,
-    HTTP_NOT_FOUND = 404
+    HTTP_NOT_FOUND = 404,
+    HTTP_PAYLOAD_TOO_LARGE = 413,
+    HTTP_SERVICE_UNAVAILABLE = 503
   };
 
   // void addToContainerData(const char* const data);
@@ -362,7 +596,132 @@ class WebServer {
 
   void eraseConfig(AsyncWebServerRequest* request);
   void onClick(AsyncWebServerRequest* request);
+  void onMetrics(AsyncWebServerRequest* request);
+  void onPanel(AsyncWebServerRequest* request);
+
+  /**
+   * Answers with the configuration as json, serialized chunk by chunk without a copy.
+   * Password elements and secret config keys are left out unless ?secrets=1 is given.
+   */
+  void onConfigExport(AsyncWebServerRequest* request);
+  void exportConfig(Print& out, bool secrets);
+  [[nodiscard]] bool isSecret(const String& key);
+
+  /**
+   * Sets all values of a json object body. Keys have to be elements holding a value
+   * or already be part of the configuration, otherwise nothing is changed.
+   * The body is not parsed incrementally. onConfigImportBody buffers it in one
+   * allocation of at most Configuration::capacity() bytes (2048) and it is parsed in
+   * place once complete. A larger body is answered with 413.
+   */
+  void onConfigImport(AsyncWebServerRequest* request);
+  void onConfigImportBody(
+    AsyncWebServerRequest* request,
+    const uint8_t* data,
+    size_t len,
+    size_t index,
+    size_t total);
+
+  /**
+   * Checks value of an import, numbers given as text are converted in place.
+   * Keys without element have to be registered with addConfigKey().
+   */
+  [[nodiscard]] bool importValue(const String& key, JsonVariant value);
+
+  /**
+   * @return false if text is no valid number for an INT or DOUBLE element
+   */
+  [[nodiscard]] bool validValue(const String& key, const String& text);
+
+  /**
+   * Stores text as native number for INT and DOUBLE elements, as text otherwise
+   */
+  void setTypedValue(const String& key, const String& text);
+
+  /**
+   * Answers with a page of the options of a list or dropdown as json:
+   * {"options":[...],"total":<matching options>}
+   */
+  void onOptions(AsyncWebServerRequest* request);
+
+  /**
+   * Sends a gzipped asset from flash as it is
+   */
+  void sendAsset(
+    AsyncWebServerRequest* request,
+    const char* contentType,
+    const uint8_t* data,
+    size_t length,
+    PGM_P etag);
+
+  /**
+   * Answers with 304 if the client already has the content of etag
+   */
+  bool notModified(AsyncWebServerRequest* request, const String& etag);
+
+  /**
+   * Counts requests of route, measures handlers which do not use send() and sheds
+   * the request if the admission control rejects it
+   */
+  ArRequestHandlerFunction instrument(
+    WebRequestMethodComposite method,
+    const String& uri,
+    AdmissionControl::RouteClass routeClass,
+    ArRequestHandlerFunction&& handler);
+
+  /**
+   * @return name of the route in metrics and admission control, the same uri is a
+   * different route for GET and POST
+   */
+  [[nodiscard]] static String routeName(
+    WebRequestMethodComposite method,
+    const String& uri);
+
+  /**
+   * Answers with a static 503 and Retry-After
+   */
+  void reject(AsyncWebServerRequest* request, size_t route, const char* reason);
   [[nodiscard]] String templateCallback(const String& templateString);
+
+  [[nodiscard]] PageVersion pageVersion() const {
+    return {m_config.version(), ChoiceElementBase::optionsVersion(), m_indexVersion};
+  }
+
+  [[nodiscard]] String pageETag(
+    const PageVersion& version,
+    size_t panel = s_allPanels) const;
+
+  /**
+   * Page template: start of the page, static ui, runtime containers and end.
+   * The page of a panel only has its container and the panel form field.
+   */
+  [[nodiscard]] PageSource pageSource(size_t panel = s_allPanels) const;
+
+  /**
+   * Streams the page through the template processor
+   */
+  [[nodiscard]] AsyncWebServerResponse* pageResponse(
+    AsyncWebServerRequest* request,
+    size_t panel);
+
+  /**
+   * Same parts as pageSource() but the placeholders are resolved while reading
+   */
+  [[nodiscard]] FlashPage::Reader flashPageReader(size_t panel);
+
+  [[nodiscard]] size_t panelCount() const {
+    return m_staticUi.panelCount + m_container.size();
+  }
+
+  [[nodiscard]] static String panelUrl(size_t panel);
+  [[nodiscard]] bool panelHasElement(size_t panel, const String& configName);
+  [[nodiscard]] String panelNavigation() const;
+
+  /**
+   * Expands the templates of the html index into the page cache file
+   */
+  [[nodiscard]] bool renderPageCache();
+  [[nodiscard]] bool pageCacheWritable() const;
   [[nodiscard]] String optionTemplate(
     const String& templ,
     const ChoiceElementBase* listValue,
@@ -375,7 +734,10 @@ class WebServer {
   };
 
   [[nodiscard]] bool containerSetupDone();
+  [[nodiscard]] bool updateHtmlIndex();
+  void buildFlashPage();
   [[nodiscard]] WriteAndCheckResult checkAndWriteHTML(bool writeFS);
+  void makeContainer(Container& container, std::stringstream& ss);
   static void makeInput(
     const Element* element,
     const String& elementValue,
@@ -396,6 +758,7 @@ class WebServer {
 
   static void makeButton(const Element* element, std::stringstream& ss);
   void makeUpload(const Element* element, std::stringstream& ss);
+  void registerUploadRoutes();
 
   [[nodiscard]] bool fileSystemAndDataChunksEqual(
     unsigned int offset,
@@ -412,7 +775,11 @@ class WebServer {
 
   [[nodiscard]] static bool isIp(const String& str);
 
+  [[nodiscard]] bool hasStaticElement(const String& configName, ElementType type) const;
+  [[nodiscard]] std::optional<ElementType> elementType(const String& configName);
+  [[nodiscard]] bool staticNameEquals(const ui::Entry& entry, const String& name) const;
   [[nodiscard]] Element* anyToElement(std::any& any);
+  [[nodiscard]] std::any* findAny(const String& key);
 };
 }  // namespace esp_gui
 
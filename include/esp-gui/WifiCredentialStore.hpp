@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_WIFICREDENTIALSTORE_HPP
+#define ESP_GUI_WIFICREDENTIALSTORE_HPP
+
+#include <Arduino.h>
+#include <esp-gui/Configuration.hpp>
+#include <esp-gui/WifiScanner.hpp>
+#include <yal/yal.hpp>
+#include <array>
+
+namespace esp_gui {
+
+/**
+ * Stores multiple known networks together with their connection history.
+ * Candidates are ranked by the rssi of the last scan, previous failures and whether
+ * the network was the one used last.
+ */
+class WifiCredentialStore {
+ public:
+  static constexpr size_t s_maxNetworks = 5;
+
+  struct Credential {
+    String ssid;
+    String password;
+    // sequence number of the last successful connection, higher is more recent.
+    // the esp has no wall clock before ntp is available, so no timestamps are used.
+    uint32_t lastSuccess = 0;
+    uint8_t failures = 0;
+  };
+
+  struct Candidate {
+    size_t index = 0;
+    // nullptr if the network was not found in the last scan
+    const WifiScanner::Network* network = nullptr;
+    int32_t score = 0;
+  };
+
+  using Candidates = std::array<Candidate, s_maxNetworks>;
+
+  explicit WifiCredentialStore(Configuration& config) :
+      m_config(config), m_logger(yal::Logger("WIFICRED")) {
+  }
+
+  void load();
+
+  /**
+   * @return key of the stored networks in the configuration
+   */
+  [[nodiscard]] static const String& configKey() {
+    return m_cfgNetworks;
+  }
+
+  /**
+   * @return true if networks has the layout written by save(), e.g. for an import
+   */
+  [[nodiscard]] static bool validNetworks(JsonVariantConst networks);
+
+  /**
+   * Writes the store to the configuration if anything relevant changed.
+   */
+  void save();
+
+  /**
+   * Adds or updates a network. Evicts the least useful network if the store is full.
+   */
+  void add(const String& ssid, const String& password);
+
+  void markSuccess(size_t index);
+  void markFailure(size_t index);
+
+  /**
+   * Ranks all stored networks against the scan results, best candidate first.
+   * @return number of candidates written to out
+   */
+  size_t rank(const WifiScanner& scanner, Candidates& out) const;
+
+  /**
+   * @return index of the network that was connected last or size() if there is none
+   */
+  [[nodiscard]] size_t mostRecent() const;
+
+  [[nodiscard]] const Credential& operator[](size_t index) const {
+    return m_networks[index];
+  }
+
+  [[nodiscard]] size_t size() const {
+    return m_count;
+  }
+
+ private:
+  [[nodiscard]] size_t find(const String& ssid) const;
+  [[nodiscard]] int32_t score(const Credential& credential, int32_t rssi) const;
+
+  Configuration& m_config;
+  yal::Logger m_logger;
+
+  std::array<Credential, s_maxNetworks> m_networks{};
+  size_t m_count = 0;
+  uint32_t m_successSequence = 0;
+  bool m_dirty = false;
+
+  static inline const String m_cfgNetworks = "wifi_networks";
+  static constexpr const char* s_keySsid = "ssid";
+  static constexpr const char* s_keyPassword = "password";
+  static constexpr const char* s_keyLastSuccess = "last_success";
+  static constexpr const char* s_keyFailures = "failures";
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_WIFICREDENTIALSTORE_HPP
@@ -6,50 +6,123 @@
 #ifndef WIFIMANAGER_HPP_
 #define WIFIMANAGER_HPP_
 
+#include <DNSServer.h>
 #include <chrono>
 
 #include <esp-gui/Configuration.hpp>
+#include <esp-gui/ConnectivityMetrics.hpp>
+#include <esp-gui/FastConnectCache.hpp>
+#include <esp-gui/ReconnectPolicy.hpp>
 #include <esp-gui/WebServer.hpp>
+#include <esp-gui/WifiCredentialStore.hpp>
+#include <esp-gui/WifiScanner.hpp>
 #include <yal/yal.hpp>
 
 namespace esp_gui {
 class WifiManager {
  public:
   WifiManager(Configuration &config, WebServer &webServer) :
-      m_webServer(webServer), m_config(config), m_logger(yal::Logger("WIFI")) {
+      m_webServer(webServer),
+      m_config(config),
+      m_logger(yal::Logger("WIFI")),
+      m_credentials(config) {
     addWifiContainers();
+    m_config.subscribe(m_cfgWifiSsid, [this]() { onCredentialsChanged(); });
+    m_config.subscribe(m_cfgWifiPassword, [this]() { onCredentialsChanged(); });
+
+    // networks of another device can be imported to a fresh one, they hold passwords
+    m_webServer.addConfigKey(
+      WifiCredentialStore::configKey(), &WifiCredentialStore::validNetworks, true);
+    m_config.subscribe(
+      WifiCredentialStore::configKey(), [this]() { m_credentials.load(); });
   };
 
   /**
-   * Setup wifi by loading configuration from config or showing cfg portal
+   * Setup wifi by loading configuration from config or showing cfg portal.
+   * Connecting to the stored networks blocks for one scan of up to 10 s to rank
+   * them. The portal does not block, it is serviced by loop() until a stored network
+   * connects. WebServer::setup has to be called afterwards.
    * @param showConfigPortal set to true to force showing config portal
    */
   void setup(bool showConfigPortal);
+
+  /**
+   * Checks the connection and drives non-blocking reconnect attempts.
+   * Attempts are spaced by the reconnect policy. Called from loop().
+   * @return true if connected
+   */
   bool checkWifi();
 
   void loop();
 
+  [[nodiscard]] bool portalActive() const {
+    return m_portalActive;
+  }
+
+  void setReconnectConfig(const ReconnectConfig &config) {
+    m_reconnectPolicy.setConfig(config);
+  }
+
+  const ConnectivityMetrics &metrics();
+
+  /**
+   * Reuse the last ip lease when connecting from the fast connect cache.
+   * Skips dhcp on wake up, only enable this if the lease is reserved in the router.
+   */
+  void setReuseIpLease(bool reuse) {
+    m_reuseIpLease = reuse;
+  }
+
  private:
-  struct fastConfig {
-    uint8_t *bssid = nullptr;
-    int32_t channel = 0;
-  };
+  void startConfigurationPortal();
+  void stopConfigurationPortal();
+  void servicePortal();
 
-  [[noreturn]] bool showConfigurationPortal();
+  void onConnected(unsigned long now);
+  void serviceReconnect(unsigned long now);
+  void scheduleReconnect(unsigned long now);
+  void onCredentialsChanged();
+  void reconnectNow(const char *reason);
   bool loadAPsFromConfig();
-  void setApList() const;
-  static bool getFastConnectConfig(const String &ssid, fastConfig &config);
+  void setApList();
 
   wl_status_t connectMultiWiFi(bool useFastConfig);
+  wl_status_t connectCandidate(
+    const WifiCredentialStore::Candidate &candidate,
+    bool useFastConfig);
+  bool connectFromCache(const WifiCredentialStore::Credential &credential);
+  wl_status_t waitForConnection(uint8_t timeout);
+  void storeFastConnect(const String &ssid);
 
   void addWifiContainers();
 
-  unsigned char m_reconnectCount = 0;
+  uint32_t m_reconnectCount = 0;
 
   WebServer &m_webServer;
   Configuration &m_config;
   yal::Logger m_logger;
+  WifiScanner m_scanner;
+  WifiCredentialStore m_credentials;
+  FastConnectCache m_fastConnectCache;
+  bool m_reuseIpLease = false;
+  uint32_t m_apListGeneration = 0;
   bool m_shouldScan = false;
+  bool m_reconnectAfterScan = false;
+
+  DNSServer m_dnsServer;
+  bool m_portalActive = false;
+
+  ReconnectPolicy m_reconnectPolicy;
+  ConnectivityMetrics m_metrics;
+  bool m_attempting = false;
+  size_t m_attemptCandidate = 0;
+  size_t m_attemptIndex = 0;
+  unsigned long m_attemptStartMillis = 0;
+  unsigned long m_nextAttemptMillis = 0;
+
+  static constexpr int s_maxDnsRequestsPerLoop = 4;
+  static constexpr unsigned long s_portalRetryInterval = 30000;
+  static constexpr unsigned long s_attemptTimeout = 10000;
 
   static inline const String m_cfgWifiSsid = "wifi_ssid";
   static inline const String m_cfgWifiPassword = "wifi_password";
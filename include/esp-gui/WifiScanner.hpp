@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_WIFISCANNER_HPP
+#define ESP_GUI_WIFISCANNER_HPP
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <yal/yal.hpp>
+#include <array>
+#include <chrono>
+
+namespace esp_gui {
+
+using std::chrono_literals::operator""ms;
+using std::chrono_literals::operator""s;
+
+/**
+ * Runs asynchronous WiFi scans and caches the results for a limited time.
+ * Results are deduplicated by SSID (strongest BSSID wins) and sorted by RSSI.
+ */
+class WifiScanner {
+ public:
+  static constexpr size_t s_maxNetworks = 16;
+  static constexpr size_t s_maxSsidLength = 32;
+  static constexpr size_t s_bssidLength = 6;
+
+  struct Network {
+    std::array<char, s_maxSsidLength + 1> ssid{};
+    std::array<uint8_t, s_bssidLength> bssid{};
+    int32_t channel = 0;
+    int32_t rssi = 0;
+  };
+
+  explicit WifiScanner(std::chrono::milliseconds ttl = 30s) :
+      m_logger(yal::Logger("SCAN")), m_ttl(ttl) {
+  }
+
+  /**
+   * Starts an asynchronous scan.
+   * @param force scan even if the cached results did not expire yet
+   * @return true if a scan is running afterwards
+   */
+  bool startScan(bool force = false);
+
+  /**
+   * Blocks until fresh results are available. Starts a scan if necessary.
+   * Used during boot where nothing else has to be serviced yet.
+   */
+  bool waitForResults(std::chrono::milliseconds timeout = 10s);
+
+  void loop();
+
+  [[nodiscard]] bool isFresh() const;
+
+  [[nodiscard]] bool scanning() const {
+    return m_scanning;
+  }
+
+  /**
+   * Incremented after each completed scan, allows consumers to detect new results.
+   */
+  [[nodiscard]] uint32_t generation() const {
+    return m_generation;
+  }
+
+  [[nodiscard]] const Network* find(const String& ssid) const;
+
+  [[nodiscard]] const Network* begin() const {
+    return m_networks.data();
+  }
+
+  [[nodiscard]] const Network* end() const {
+    return m_networks.data() + m_count;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return m_count;
+  }
+
+ private:
+  void collectResults(int8_t networksFound);
+  void insert(const String& ssid, const uint8_t* bssid, int32_t channel, int32_t rssi);
+
+  yal::Logger m_logger;
+  const std::chrono::milliseconds m_ttl;
+
+  std::array<Network, s_maxNetworks> m_networks{};
+  size_t m_count = 0;
+
+  unsigned long m_lastScanMillis = 0;
+  uint32_t m_generation = 0;
+  bool m_scanning = false;
+};
+
+}  // namespace esp_gui
+
+#endif  // ESP_GUI_WIFISCANNER_HPP
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/AdmissionControl.hpp>
+#include <esp-gui/HeapProfiler.hpp>
+
+namespace esp_gui {
+
+const char* AdmissionControl::admit(size_t route, const RequestMetrics& metrics) const {
+  const auto routeClass = m_routeClasses[route];
+  if (routeClass != RouteClass::CONTROL) {
+    const auto* reason = checkHeap();
+    if (reason != nullptr) {
+      return reason;
+    }
+  }
+
+  const auto limit = m_limits[static_cast<size_t>(routeClass)];
+  if (limit == 0) {
+    return nullptr;
+  }
+
+  uint32_t inFlight = 0;
+  for (size_t i = 0; i < metrics.routeCount(); ++i) {
+    if (m_routeClasses[i] == routeClass) {
+      inFlight += metrics.inFlight(i);
+    }
+  }
+  return inFlight >= limit ? "too many responses in flight" : nullptr;
+}
+
+const char* AdmissionControl::admitUpload(
+  AsyncWebServerRequest* request,
+  size_t index,
+  bool final) {
+  if (index == 0) {
+    const char* reason = nullptr;
+    if (
+      m_upload != nullptr && m_upload != request &&
+      millis() - m_uploadActivity < s_uploadIdleMillis) {
+      reason = "upload in progress";
+    } else {
+      reason = checkHeap();
+    }
+
+    if (reason != nullptr) {
+      m_rejectedUpload = request;
+      return reason;
+    }
+    m_upload = request;
+    // a rejected upload which disconnected before its handler ran never cleared the
+    // pointer, its address may be reused by this request
+    if (m_rejectedUpload == request) {
+      m_rejectedUpload = nullptr;
+    }
+  } else if (request != m_upload) {
+    // remaining chunks of a rejected upload
+    return "upload rejected";
+  }
+
+  m_uploadActivity = millis();
+  if (final) {
+    m_upload = nullptr;
+  }
+  return nullptr;
+}
+
+const char* AdmissionControl::checkHeap() const {
+  if (EspClass::getFreeHeap() < m_minFreeHeap) {
+    return "low free heap";
+  }
+  if (HeapProfiler::maxFreeBlock() < m_minMaxFreeBlock) {
+    return "heap fragmented";
+  }
+  return nullptr;
+}
+
+}  // namespace esp_gui
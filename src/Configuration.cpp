@@ -6,11 +6,42 @@
 #include <Arduino.h>
 #include <LittleFS.h>
 #include <esp-gui/Configuration.hpp>
+#include <esp-gui/HeapProfiler.hpp>
 #include <sstream>
 
 namespace esp_gui {
 
+// copying a variant only copies links to strings which were parsed in place,
+// the buffer they point to may be freed right after the values were set
+static bool deepCopy(JsonVariantConst source, JsonVariant target) {
+  if (source.is<JsonObjectConst>()) {
+    auto object = target.to<JsonObject>();
+    for (const auto& kv : source.as<JsonObjectConst>()) {
+      if (!deepCopy(kv.value(), object[String(kv.key().c_str())].to<JsonVariant>())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (source.is<JsonArrayConst>()) {
+    auto array = target.to<JsonArray>();
+    for (const auto& value : source.as<JsonArrayConst>()) {
+      if (!deepCopy(value, array.add())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (source.is<const char*>()) {
+    return target.set(String(source.as<const char*>()));
+  }
+  return target.set(source);
+}
+
 void Configuration::setup() {
+  HeapProfiler::Scope profile("config_load");
   {
     m_logger.log(yal::Level::DEBUG, "Loading config");
     FileHandle file(m_configFile);
@@ -24,6 +55,8 @@ void Configuration::setup() {
   }
 
   // Deserialize the JSON document
+  ++m_version;
+  changed(String());
   DeserializationError error = deserializeJson(m_config, m_jsonData);
   if (error == DeserializationError::Ok) {
     m_logger.log(yal::Level::INFO, "Successfully loaded config");
@@ -67,12 +100,112 @@ void Configuration::store() {
   logConfig();
 }
 
+bool Configuration::setValues(JsonObjectConst values) {
+  // changed on a copy, a partial import must not be visible or stored
+  DynamicJsonDocument staged(m_jsonData.size());
+  staged.set(m_config);
+
+  std::vector<const char*> changedKeys;
+  for (const auto& kv : values) {
+    if (staged[kv.key()] == kv.value()) {
+      continue;
+    }
+    if (!deepCopy(kv.value(), staged[String(kv.key().c_str())].to<JsonVariant>())) {
+      m_logger.log(yal::Level::ERROR, "Values do not fit into the configuration");
+      return false;
+    }
+    changedKeys.push_back(kv.key().c_str());
+  }
+
+  if (staged.overflowed()) {
+    m_logger.log(yal::Level::ERROR, "Values do not fit into the configuration");
+    return false;
+  }
+  if (changedKeys.empty()) {
+    m_logger.log(yal::Level::DEBUG, "skipping set, values already in config");
+    return true;
+  }
+
+  m_config = std::move(staged);
+  ++m_version;
+  for (const auto* key : changedKeys) {
+    changed(key);
+  }
+  m_logger.log(yal::Level::INFO, "Changed % values", changedKeys.size());
+  store();
+  return true;
+}
+
+void Configuration::reload() {
+  DynamicJsonDocument current(m_jsonData.size());
+  current.set(m_config);
+
+  m_jsonData.fill(0);
+  m_config.clear();
+  setup();
+
+  for (const auto& kv : current.as<JsonObjectConst>()) {
+    m_config[kv.key()] = kv.value();
+  }
+  store();
+}
+
 void Configuration::reset(bool persist) {
   m_logger.log(yal::Level::WARNING, "Resetting configuration!");
   m_config = DynamicJsonDocument(m_jsonData.size());
+  ++m_version;
+  changed(String());
   if (persist) {
     store();
   }
 }
 
+size_t Configuration::subscribe(const String& key, OnChange&& onChange) {
+  for (size_t id = 0; id < m_subscriptions.size(); ++id) {
+    auto& subscription = m_subscriptions[id];
+    if (!subscription.onChange) {
+      subscription = {key, std::move(onChange), false};
+      return id;
+    }
+  }
+
+  m_subscriptions.push_back({key, std::move(onChange), false});
+  return m_subscriptions.size() - 1;
+}
+
+void Configuration::unsubscribe(size_t id) {
+  if (id < m_subscriptions.size()) {
+    m_subscriptions[id] = {};
+  }
+}
+
+void Configuration::loop() {
+  if (!m_changesPending) {
+    return;
+  }
+
+  // callbacks may change values again, these are dispatched by the next loop
+  m_changesPending = false;
+  for (auto& subscription : m_subscriptions) {
+    if (!subscription.pending) {
+      continue;
+    }
+    subscription.pending = false;
+    if (subscription.onChange) {
+      m_logger.log(
+        yal::Level::DEBUG, "Notifying subscriber of '%'", subscription.key.c_str());
+      subscription.onChange();
+    }
+  }
+}
+
+void Configuration::changed(const String& key) {
+  for (auto& subscription : m_subscriptions) {
+    if (key.isEmpty() || subscription.key.isEmpty() || subscription.key == key) {
+      subscription.pending = true;
+      m_changesPending = true;
+    }
+  }
+}
+
 }  // namespace esp_gui
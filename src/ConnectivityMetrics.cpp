@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/ConnectivityMetrics.hpp>
+
+namespace esp_gui {
+
+void ConnectivityMetrics::recordConnectTime(uint32_t durationMs) {
+  size_t bucket = 0;
+  while (bucket < s_connectBuckets.size() && durationMs > s_connectBuckets[bucket]) {
+    ++bucket;
+  }
+  ++m_connectHistogram[bucket];
+}
+
+void ConnectivityMetrics::recordAttempt(bool success) {
+  ++m_attempts;
+  if (!success) {
+    ++m_failedAttempts;
+  }
+}
+
+void ConnectivityMetrics::recordOffline(unsigned long nowMillis) {
+  if (!m_online) {
+    return;
+  }
+  m_online = false;
+  m_offlineSinceMillis = nowMillis;
+  ++m_disconnects;
+}
+
+void ConnectivityMetrics::recordOnline(unsigned long nowMillis) {
+  if (m_online) {
+    return;
+  }
+  m_online = true;
+  m_offlineMillis += nowMillis - m_offlineSinceMillis;
+}
+
+uint64_t ConnectivityMetrics::offlineMillis(unsigned long nowMillis) const {
+  if (m_online) {
+    return m_offlineMillis;
+  }
+  return m_offlineMillis + (nowMillis - m_offlineSinceMillis);
+}
+
+}  // namespace esp_gui
@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/DeltaStage.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+bool DeltaStage::begin(AsyncWebServerRequest* request, const String& filename) {
+  m_input.reset(new (std::nothrow) uint8_t[s_inputSize]);
+  if (!m_input) {
+    setError("not enough memory for patch buffer");
+    return false;
+  }
+
+  m_client = request->client();
+  m_pendingAck = 0;
+  m_consumed = 0;
+  m_inputPos = 0;
+  m_inputSize = 0;
+  m_inputComplete = false;
+  m_produced = 0;
+  m_remaining = 0;
+  m_state = State::HEADER;
+  return UploadStage::begin(request, filename);
+}
+
+bool DeltaStage::write(const uint8_t* data, size_t len) {
+  if (m_state == State::IDLE) {
+    return false;
+  }
+
+  if (m_inputSize + len > s_inputSize) {
+    memmove(m_input.get(), m_input.get() + m_inputPos, available());
+    m_inputSize -= m_inputPos;
+    m_inputPos = 0;
+  }
+  if (m_inputSize + len > s_inputSize) {
+    fail("patch buffer overrun");
+    return false;
+  }
+
+  memcpy(m_input.get() + m_inputSize, data, len);
+  m_inputSize += len;
+
+  // acked again once loop() consumed the data
+  if (m_client != nullptr) {
+    m_client->ackLater();
+    m_pendingAck += len;
+  }
+  return true;
+}
+
+bool DeltaStage::end() {
+  // the image is completed from loop(), see busy()
+  m_inputComplete = true;
+  return m_state != State::IDLE;
+}
+
+void DeltaStage::abort() {
+  m_state = State::IDLE;
+  m_input.reset();
+  UploadStage::abort();
+}
+
+void DeltaStage::disconnected() {
+  m_client = nullptr;
+  UploadStage::disconnected();
+}
+
+void DeltaStage::loop() {
+  if (m_state != State::IDLE) {
+    size_t budget = s_outputPerLoop;
+    while (m_state != State::IDLE && step(budget)) {
+    }
+    releaseAck();
+  }
+  UploadStage::loop();
+}
+
+bool DeltaStage::step(size_t& budget) {
+  switch (m_state) {
+    case State::HEADER:
+      if (available() < s_headerSize) {
+        break;
+      }
+      return parseHeader();
+
+    case State::OPCODE:
+      if (m_produced == m_targetSize) {
+        if (available() > 0) {
+          fail("patch has data after the image");
+        } else if (m_inputComplete) {
+          finish();
+        }
+        return false;
+      }
+      return parseOpcode();
+
+    case State::COPY: {
+      if (budget == 0) {
+        return false;
+      }
+      const auto chunk = std::min<size_t>({m_remaining, m_copyBuffer.size(), budget});
+      if (!EspClass::flashRead(m_copyOffset, m_copyBuffer.data(), chunk)) {
+        fail("reading running firmware failed");
+        return false;
+      }
+      if (!UploadStage::write(m_copyBuffer.data(), chunk)) {
+        fail(nullptr);
+        return false;
+      }
+      m_copyOffset += chunk;
+      m_remaining -= chunk;
+      m_produced += chunk;
+      budget -= chunk;
+      if (m_remaining == 0) {
+        m_state = State::OPCODE;
+      }
+      return true;
+    }
+
+    case State::LITERAL: {
+      if (budget == 0 || available() == 0) {
+        break;
+      }
+      const auto chunk = std::min<size_t>({m_remaining, available(), budget});
+      if (!UploadStage::write(m_input.get() + m_inputPos, chunk)) {
+        fail(nullptr);
+        return false;
+      }
+      consume(chunk);
+      m_remaining -= chunk;
+      m_produced += chunk;
+      budget -= chunk;
+      if (m_remaining == 0) {
+        m_state = State::OPCODE;
+      }
+      return true;
+    }
+
+    case State::IDLE:
+      return false;
+  }
+
+  if (m_inputComplete && budget > 0) {
+    fail("patch is truncated");
+  }
+  return false;
+}
+
+bool DeltaStage::parseHeader() {
+  const auto* header = m_input.get() + m_inputPos;
+  if (memcmp(header, "EGD1", 4) != 0) {
+    fail("not a delta patch");
+    return false;
+  }
+
+  m_baseSize = readU32(header + 4);
+  String baseMd5;
+  for (size_t i = 0; i < 16; ++i) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", header[8 + i]);
+    baseMd5 += hex;
+  }
+  m_targetSize = readU32(header + 24);
+  consume(s_headerSize);
+
+  // the md5 hashes the whole sketch, only the first patch pays for it, the core
+  // caches the value
+  if (m_baseSize != EspClass::getSketchSize() || baseMd5 != EspClass::getSketchMD5()) {
+    m_logger.log(
+      yal::Level::ERROR,
+      "Patch is based on %, running %",
+      baseMd5.c_str(),
+      EspClass::getSketchMD5().c_str());
+    fail("patch does not match running firmware");
+    return false;
+  }
+
+  m_logger.log(
+    yal::Level::INFO, "Applying patch, % -> % bytes", m_baseSize, m_targetSize);
+  m_state = State::OPCODE;
+  return true;
+}
+
+bool DeltaStage::parseOpcode() {
+  const auto* op = m_input.get() + m_inputPos;
+  size_t opSize = 0;
+  if (available() == 0) {
+    opSize = 1;
+  } else if (op[0] == s_opCopy) {
+    opSize = 9;
+  } else if (op[0] == s_opLiteral) {
+    opSize = 5;
+  } else {
+    fail("unknown patch operation");
+    return false;
+  }
+
+  if (available() < opSize) {
+    if (m_inputComplete) {
+      fail("patch is truncated");
+    }
+    return false;
+  }
+
+  const auto length = readU32(op + opSize - 4);
+  if (length > m_targetSize - m_produced) {
+    fail("patch exceeds image size");
+    return false;
+  }
+
+  if (op[0] == s_opCopy) {
+    m_copyOffset = readU32(op + 1);
+    if (length > m_baseSize || m_copyOffset > m_baseSize - length) {
+      fail("patch copies outside of running firmware");
+      return false;
+    }
+    m_state = State::COPY;
+  } else {
+    m_state = State::LITERAL;
+  }
+
+  consume(opSize);
+  m_remaining = length;
+  if (m_remaining == 0) {
+    m_state = State::OPCODE;
+  }
+  return true;
+}
+
+void DeltaStage::finish() {
+  m_logger.log(yal::Level::INFO, "Patch applied, % bytes", m_produced);
+  m_state = State::IDLE;
+  m_input.reset();
+  if (!UploadStage::end()) {
+    UploadStage::abort();
+  }
+}
+
+void DeltaStage::fail(const char* error) {
+  if (error != nullptr) {
+    setError(error);
+  }
+  const auto* reason = this->error();
+  m_logger.log(
+    yal::Level::ERROR, "Applying patch failed: %", reason != nullptr ? reason : "-");
+  abort();
+
+  // do not leave the sender waiting for a window
+  m_consumed = m_pendingAck;
+  releaseAck();
+}
+
+void DeltaStage::releaseAck() {
+  const auto len = std::min(m_pendingAck, m_consumed);
+  if (m_client != nullptr && len > 0) {
+    m_client->ack(len);
+  }
+  m_pendingAck -= len;
+  m_consumed -= len;
+}
+
+uint32_t DeltaStage::readU32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+}  // namespace esp_gui
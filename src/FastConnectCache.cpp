@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <coredecls.h>
+#include <esp-gui/FastConnectCache.hpp>
+
+namespace esp_gui {
+
+bool FastConnectCache::load(const String& ssid, Entry& entry) {
+  Record record{};
+  if (!EspClass::rtcUserMemoryRead(
+        s_rtcOffset, reinterpret_cast<uint32_t*>(&record), sizeof(record))) {
+    m_logger.log(yal::Level::ERROR, "Failed to read rtc memory");
+    return false;
+  }
+
+  if (record.magic != s_magic || record.crc != recordCrc(record)) {
+    m_logger.log(yal::Level::DEBUG, "No valid fast connect record");
+    return false;
+  }
+
+  if (record.ssidHash != ssidHash(ssid)) {
+    m_logger.log(yal::Level::DEBUG, "Fast connect record belongs to another ssid");
+    return false;
+  }
+
+  entry = record.entry;
+  return true;
+}
+
+void FastConnectCache::store(const String& ssid, const Entry& entry) {
+  Record record{};
+  record.magic = s_magic;
+  record.ssidHash = ssidHash(ssid);
+  record.entry = entry;
+  record.crc = recordCrc(record);
+
+  Record current{};
+  if (
+    EspClass::rtcUserMemoryRead(
+      s_rtcOffset, reinterpret_cast<uint32_t*>(&current), sizeof(current)) &&
+    std::memcmp(&current, &record, sizeof(record)) == 0) {
+    return;
+  }
+
+  if (!EspClass::rtcUserMemoryWrite(
+        s_rtcOffset, reinterpret_cast<uint32_t*>(&record), sizeof(record))) {
+    m_logger.log(yal::Level::ERROR, "Failed to write rtc memory");
+    return;
+  }
+  m_logger.log(yal::Level::DEBUG, "Stored fast connect record, channel %", entry.channel);
+}
+
+void FastConnectCache::invalidate() {
+  Record record{};
+  EspClass::rtcUserMemoryWrite(
+    s_rtcOffset, reinterpret_cast<uint32_t*>(&record), sizeof(record));
+}
+
+uint32_t FastConnectCache::recordCrc(const Record& record) {
+  const auto* data = reinterpret_cast<const uint8_t*>(&record) + sizeof(record.crc);
+  return crc32(data, sizeof(record) - sizeof(record.crc));
+}
+
+uint32_t FastConnectCache::ssidHash(const String& ssid) {
+  return crc32(ssid.c_str(), ssid.length());
+}
+
+}  // namespace esp_gui
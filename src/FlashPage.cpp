@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/FlashPage.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+size_t FlashPage::addRegion(PGM_P data, size_t length) {
+  Region region{data, length, {}};
+
+  // flash can only be read in words, scan it in chunks
+  std::array<char, 64> chunk{};
+  bool inPlaceholder = false;
+  size_t start = 0;
+  for (size_t offset = 0; offset < length; offset += chunk.size()) {
+    const auto chunkLength = std::min(chunk.size(), length - offset);
+    memcpy_P(chunk.data(), data + offset, chunkLength);
+    for (size_t i = 0; i < chunkLength; ++i) {
+      const auto position = offset + i;
+      if (chunk[i] == '%') {
+        if (inPlaceholder) {
+          region.slots.push_back({start, static_cast<uint8_t>(position - start + 1)});
+        } else {
+          start = position;
+        }
+        inPlaceholder = !inPlaceholder;
+      } else if (inPlaceholder && position - start > s_maxNameLength) {
+        inPlaceholder = false;
+      }
+    }
+  }
+
+  m_regions.push_back(std::move(region));
+  return m_regions.size() - 1;
+}
+
+void FlashPage::Reader::add(const Part& part) {
+  if (m_partCount < m_parts.size()) {
+    m_parts[m_partCount++] = part;
+  }
+}
+
+void FlashPage::Reader::startPart() {
+  const auto& part = m_parts[m_part];
+  const auto& slots = m_page.m_regions[part.region].slots;
+  m_position = part.offset;
+  m_slot = std::lower_bound(
+             slots.begin(),
+             slots.end(),
+             part.offset,
+             [](const Slot& slot, size_t offset) { return slot.offset < offset; }) -
+    slots.begin();
+  m_started = true;
+}
+
+size_t FlashPage::Reader::read(uint8_t* buffer, size_t maxLen) {
+  size_t length = 0;
+  while (length < maxLen) {
+    if (m_valueOffset < m_value.length()) {
+      const auto copied = std::min(maxLen - length, m_value.length() - m_valueOffset);
+      memcpy(buffer + length, m_value.c_str() + m_valueOffset, copied);
+      m_valueOffset += copied;
+      length += copied;
+      continue;
+    }
+
+    if (m_part == m_partCount) {
+      break;
+    }
+    if (!m_started) {
+      startPart();
+    }
+
+    const auto& part = m_parts[m_part];
+    const auto& region = m_page.m_regions[part.region];
+    const auto end = part.offset + part.length;
+    const auto hasSlot =
+      m_slot < region.slots.size() && region.slots[m_slot].offset < end;
+    const auto next = hasSlot ? region.slots[m_slot].offset : end;
+
+    if (m_position < next) {
+      const auto copied = std::min(maxLen - length, next - m_position);
+      memcpy_P(buffer + length, region.data + m_position, copied);
+      m_position += copied;
+      length += copied;
+      continue;
+    }
+
+    if (!hasSlot) {
+      ++m_part;
+      m_started = false;
+      continue;
+    }
+
+    const auto& slot = region.slots[m_slot++];
+    const auto nameLength = slot.length - 2U;
+    if (nameLength == 0) {
+      m_value = "%";
+    } else {
+      std::array<char, s_maxNameLength + 1> name{};
+      memcpy_P(name.data(), region.data + slot.offset + 1, nameLength);
+      m_value = m_resolve(name.data());
+    }
+    m_valueOffset = 0;
+    m_position += slot.length;
+  }
+  return length;
+}
+
+}  // namespace esp_gui
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/FlashString.hpp>
+#include <algorithm>
+#include <array>
+
+namespace esp_gui {
+
+size_t FlashString::length() const {
+  if (m_flash != nullptr) {
+    return strlen_P(reinterpret_cast<PGM_P>(m_flash));
+  }
+  return m_ram.length();
+}
+
+int FlashString::compare(const char* other) const {
+  if (m_flash != nullptr) {
+    return -strcmp_P(other, reinterpret_cast<PGM_P>(m_flash));
+  }
+  return strcmp(m_ram.c_str(), other);
+}
+
+int FlashString::compare(const FlashString& other) const {
+  if (other.m_flash == nullptr) {
+    return compare(other.m_ram.c_str());
+  }
+  if (m_flash == nullptr) {
+    return -other.compare(m_ram.c_str());
+  }
+  return compare(other.toString().c_str());
+}
+
+bool FlashString::startsWith(const String& prefix) const {
+  if (m_flash != nullptr) {
+    const auto* text = reinterpret_cast<PGM_P>(m_flash);
+    return strncmp_P(prefix.c_str(), text, prefix.length()) == 0;
+  }
+  return m_ram.startsWith(prefix);
+}
+
+void FlashString::appendTo(String& out) const {
+  if (m_flash != nullptr) {
+    out += m_flash;
+  } else {
+    out += m_ram;
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, const FlashString& text) {
+  if (text.m_flash == nullptr) {
+    return out << text.m_ram.c_str();
+  }
+
+  // flash can only be read in words, copy it in chunks
+  const auto* source = reinterpret_cast<PGM_P>(text.m_flash);
+  std::array<char, 32> buffer{};
+  auto remaining = strlen_P(source);
+  while (remaining > 0) {
+    const auto chunk = std::min(remaining, buffer.size());
+    memcpy_P(buffer.data(), source, chunk);
+    out.write(buffer.data(), static_cast<std::streamsize>(chunk));
+    source += chunk;
+    remaining -= chunk;
+  }
+  return out;
+}
+
+}  // namespace esp_gui
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/HeapProfiler.hpp>
+#include <umm_malloc/umm_malloc.h>
+#include <yal/yal.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+std::array<HeapProfiler::Phase, HeapProfiler::s_maxPhases> HeapProfiler::s_phases{};
+size_t HeapProfiler::s_phaseCount = 0;
+HeapProfiler::Scope* HeapProfiler::s_current = nullptr;
+
+HeapProfiler::Scope::Scope(const char* name) :
+    m_name(name),
+    m_parent(s_current),
+    m_startFree(EspClass::getFreeHeap()),
+    m_outerMin(lowWatermark()) {
+  s_current = this;
+  resetLowWatermark();
+}
+
+HeapProfiler::Scope::~Scope() {
+  const auto endFree = EspClass::getFreeHeap();
+  const auto minFree = std::min({lowWatermark(), m_nestedMin, endFree});
+  s_current = m_parent;
+  if (m_parent != nullptr) {
+    // the parent can not read its watermark from before this scope reset it
+    m_parent->m_nestedMin = std::min({m_parent->m_nestedMin, m_outerMin, minFree});
+  }
+
+  const auto retained = static_cast<int32_t>(m_startFree) - static_cast<int32_t>(endFree);
+  const auto peak = minFree < m_startFree ? m_startFree - minFree : 0U;
+  record(m_name, retained, peak);
+}
+
+uint32_t HeapProfiler::lowWatermark() {
+#if defined(UMM_STATS) || defined(UMM_STATS_FULL)
+  return umm_free_heap_size_lw_min();
+#else
+  return EspClass::getFreeHeap();
+#endif
+}
+
+void HeapProfiler::resetLowWatermark() {
+#if defined(UMM_STATS) || defined(UMM_STATS_FULL)
+  umm_free_heap_size_min_reset();
+#endif
+}
+
+void HeapProfiler::record(const char* name, int32_t retained, uint32_t peak) {
+  auto* phase = std::find_if(
+    s_phases.begin(), s_phases.begin() + s_phaseCount, [name](const Phase& phase) {
+      return phase.name == name;
+    });
+
+  if (phase == s_phases.begin() + s_phaseCount) {
+    if (s_phaseCount == s_maxPhases) {
+      return;
+    }
+    phase->name = name;
+    ++s_phaseCount;
+  }
+
+  const auto maxBlock = maxFreeBlock();
+  ++phase->runs;
+  phase->lastRetained = retained;
+  phase->maxRetained = std::max(phase->maxRetained, retained);
+  phase->lastPeak = peak;
+  phase->maxPeak = std::max(phase->maxPeak, peak);
+  phase->minMaxBlock = std::min(phase->minMaxBlock, maxBlock);
+
+  static yal::Logger logger("HEAP");
+  logger.log(
+    yal::Level::DEBUG,
+    "% retained %, peak %, max block %, fragmentation % percent",
+    name,
+    retained,
+    peak,
+    maxBlock,
+    fragmentation());
+}
+
+}  // namespace esp_gui
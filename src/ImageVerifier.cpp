@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/ImageVerifier.hpp>
+
+namespace esp_gui {
+
+bool ImageVerifier::begin(size_t expectedSize, const String& md5, const String& sha256) {
+  m_expectedSize = expectedSize;
+  m_size = 0;
+  m_error = nullptr;
+
+  m_checkMd5 = !md5.isEmpty();
+  if (m_checkMd5) {
+    if (!parseHex(md5, m_expectedMd5.data(), m_expectedMd5.size())) {
+      m_error = "malformed md5";
+      return false;
+    }
+    m_md5.begin();
+  }
+
+  m_checkSha256 = !sha256.isEmpty();
+  if (m_checkSha256) {
+    if (!parseHex(sha256, m_expectedSha256.data(), m_expectedSha256.size())) {
+      m_error = "malformed sha256";
+      return false;
+    }
+    br_sha256_init(&m_sha256);
+  }
+
+  m_logger.log(
+    yal::Level::DEBUG,
+    "Verifying size %, md5 %, sha256 %",
+    m_expectedSize,
+    m_checkMd5,
+    m_checkSha256);
+  return true;
+}
+
+bool ImageVerifier::update(const uint8_t* data, size_t len) {
+  m_size += len;
+  if (m_expectedSize != 0 && m_size > m_expectedSize) {
+    m_error = "image larger than expected";
+    m_logger.log(
+      yal::Level::ERROR, "Received % bytes, expected %", m_size, m_expectedSize);
+    return false;
+  }
+
+  if (m_checkMd5) {
+    m_md5.add(data, len);
+  }
+  if (m_checkSha256) {
+    br_sha256_update(&m_sha256, data, len);
+  }
+  return true;
+}
+
+bool ImageVerifier::finish() {
+  if (m_error != nullptr) {
+    return false;
+  }
+
+  if (m_expectedSize != 0 && m_size != m_expectedSize) {
+    m_error = "image size mismatch";
+    m_logger.log(
+      yal::Level::ERROR, "Received % bytes, expected %", m_size, m_expectedSize);
+    return false;
+  }
+
+  if (m_checkMd5) {
+    std::array<uint8_t, s_md5Length> digest{};
+    m_md5.calculate();
+    m_md5.getBytes(digest.data());
+    if (digest != m_expectedMd5) {
+      m_error = "md5 mismatch";
+      m_logger.log(yal::Level::ERROR, "MD5 mismatch, got %", m_md5.toString().c_str());
+      return false;
+    }
+  }
+
+  if (m_checkSha256) {
+    std::array<uint8_t, s_sha256Length> digest{};
+    br_sha256_out(&m_sha256, digest.data());
+    if (digest != m_expectedSha256) {
+      m_error = "sha256 mismatch";
+      m_logger.log(yal::Level::ERROR, "SHA256 mismatch");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ImageVerifier::parseHex(const String& hex, uint8_t* out, size_t len) {
+  if (hex.length() != len * 2) {
+    return false;
+  }
+
+  const auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    c = static_cast<char>(tolower(c));
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    return -1;
+  };
+
+  for (size_t i = 0; i < len; ++i) {
+    const auto high = nibble(hex[2 * i]);
+    const auto low = nibble(hex[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    out[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+  return true;
+}
+
+}  // namespace esp_gui
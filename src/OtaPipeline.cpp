@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <Updater.h>
+#include <esp-gui/OtaPipeline.hpp>
+#include <algorithm>
+#include <new>
+
+namespace esp_gui {
+
+static const char* const s_rejectMd5 = "00000000000000000000000000000000";
+
+bool OtaPipeline::begin(size_t size, int command, AsyncClient* client) {
+  release();
+
+  m_buffers.reset(new (std::nothrow) uint8_t[2 * s_bufferSize]);
+  if (!m_buffers) {
+    m_logger.log(yal::Level::ERROR, "Not enough memory for update buffers");
+    m_state = State::FAILED;
+    return false;
+  }
+
+  Update.runAsync(true);
+  if (!Update.begin(size, command)) {
+    Update.printError(Serial);
+    release();
+    m_state = State::FAILED;
+    return false;
+  }
+
+  m_client = client;
+  m_sizes = {};
+  m_fillIndex = 0;
+  m_received = 0;
+  m_written = 0;
+  m_startMillis = millis();
+  m_endMillis = 0;
+  m_state = State::RECEIVING;
+  return true;
+}
+
+bool OtaPipeline::write(const uint8_t* data, size_t len) {
+  if (m_state != State::RECEIVING) {
+    return false;
+  }
+
+  m_received += len;
+  const auto chunkLen = len;
+  while (len > 0) {
+    if (m_sizes[m_fillIndex] == s_bufferSize) {
+      const auto readyIndex = 1 - m_fillIndex;
+      // both buffers are full, the sender was faster than the throttling
+      if (m_sizes[readyIndex] != 0 && !flush(readyIndex)) {
+        return false;
+      }
+      m_fillIndex = readyIndex;
+      continue;
+    }
+
+    auto* buffer = m_buffers.get() + m_fillIndex * s_bufferSize;
+    const auto chunk = std::min(len, s_bufferSize - m_sizes[m_fillIndex]);
+    std::memcpy(buffer + m_sizes[m_fillIndex], data, chunk);
+    m_sizes[m_fillIndex] += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+
+  if (m_sizes[m_fillIndex] == s_bufferSize && m_sizes[1 - m_fillIndex] == 0) {
+    m_fillIndex = 1 - m_fillIndex;
+  }
+
+  // a full buffer waits for the flash, hold back the ack until it is written.
+  // only the body bytes are known here, multipart headers in the same packet stay
+  // unacked which shrinks the window by a few bytes until the connection closes.
+  if (m_client != nullptr && m_sizes[1 - m_fillIndex] == s_bufferSize) {
+    m_client->ackLater();
+    m_pendingAck += chunkLen;
+  }
+
+  return true;
+}
+
+bool OtaPipeline::end() {
+  if (m_state != State::RECEIVING) {
+    return false;
+  }
+
+  const auto readyIndex = 1 - m_fillIndex;
+  const auto success = (m_sizes[readyIndex] == 0 || flush(readyIndex)) &&
+                       (m_sizes[m_fillIndex] == 0 || flush(m_fillIndex)) &&
+                       Update.end(true);
+  if (!success) {
+    Update.printError(Serial);
+  }
+
+  releaseAck();
+  release();
+  m_endMillis = millis();
+  m_state = success ? State::FINISHED : State::FAILED;
+  m_logger.log(
+    yal::Level::INFO,
+    "Update %, wrote % bytes with % bytes/s",
+    success ? "finished" : "failed",
+    m_written,
+    bytesPerSecond());
+  return success;
+}
+
+void OtaPipeline::abort() {
+  if (m_state != State::RECEIVING) {
+    return;
+  }
+
+  m_logger.log(yal::Level::WARNING, "Aborting update");
+  // end(false) still commits an image whose expected size was written completely,
+  // e.g. if the digest check fails at the last chunk. The updater has no abort,
+  // an md5 no image has makes end() fail and reset the update instead.
+  if (!Update.hasError()) {
+    Update.setMD5(s_rejectMd5);
+  }
+  Update.end(false);
+  Update.clearError();
+  releaseAck();
+  release();
+  m_endMillis = millis();
+  m_state = State::FAILED;
+}
+
+void OtaPipeline::loop() {
+  if (m_state != State::RECEIVING) {
+    return;
+  }
+
+  const auto readyIndex = 1 - m_fillIndex;
+  if (m_sizes[readyIndex] == 0) {
+    return;
+  }
+
+  if (!flush(readyIndex)) {
+    abort();
+    return;
+  }
+  releaseAck();
+}
+
+unsigned long OtaPipeline::elapsedMillis() const {
+  if (m_state == State::IDLE) {
+    return 0;
+  }
+  return (m_endMillis != 0 ? m_endMillis : millis()) - m_startMillis;
+}
+
+uint32_t OtaPipeline::bytesPerSecond() const {
+  const auto elapsed = elapsedMillis();
+  if (elapsed == 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>((static_cast<uint64_t>(m_received) * 1000U) / elapsed);
+}
+
+bool OtaPipeline::flush(size_t index) {
+  auto* buffer = m_buffers.get() + index * s_bufferSize;
+  const auto size = m_sizes[index];
+  m_sizes[index] = 0;
+  if (Update.hasError() || Update.write(buffer, size) != size) {
+    Update.printError(Serial);
+    return false;
+  }
+
+  m_written += size;
+  return true;
+}
+
+void OtaPipeline::releaseAck() {
+  if (m_client != nullptr && m_pendingAck > 0) {
+    m_client->ack(m_pendingAck);
+  }
+  m_pendingAck = 0;
+}
+
+void OtaPipeline::release() {
+  m_buffers.reset();
+  m_client = nullptr;
+}
+
+}  // namespace esp_gui
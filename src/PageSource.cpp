@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/PageSource.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+void PageSource::addFlash(PGM_P data, size_t length) {
+  if (m_segmentCount < m_segments.size()) {
+    m_segments[m_segmentCount++] = {data, length, nullptr, 0};
+  }
+}
+
+void PageSource::addFile(const char* path, size_t offset, size_t length) {
+  if (m_segmentCount < m_segments.size()) {
+    m_segments[m_segmentCount++] = {nullptr, length, path, offset};
+  }
+}
+
+size_t PageSource::read(uint8_t* buffer, size_t maxLen) {
+  size_t length = 0;
+  while (length < maxLen && m_current < m_segmentCount) {
+    const auto& segment = m_segments[m_current];
+    const auto remaining = std::min(maxLen - length, segment.length - m_offset);
+    size_t copied = 0;
+    if (segment.path == nullptr) {
+      copied = remaining;
+      memcpy_P(buffer + length, segment.data + m_offset, copied);
+    } else {
+      if (!m_file && m_fileSystem.begin()) {
+        m_file = LittleFS.open(segment.path, "r");
+        if (m_file && !m_file.seek(segment.offset, SeekSet)) {
+          m_file.close();
+        }
+      }
+      if (m_file) {
+        copied = m_file.read(buffer + length, remaining);
+      }
+    }
+
+    if (copied == 0) {
+      if (m_file) {
+        m_file.close();
+      }
+      ++m_current;
+      m_offset = 0;
+      continue;
+    }
+    m_offset += copied;
+    length += copied;
+  }
+  return length;
+}
+
+}  // namespace esp_gui
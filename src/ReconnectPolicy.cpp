@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/ReconnectPolicy.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+std::chrono::milliseconds ReconnectPolicy::nextDelay() {
+  const auto initial = static_cast<float>(m_config.initialDelay.count());
+  const auto max = static_cast<float>(m_config.maxDelay.count());
+
+  auto delayMs = initial;
+  for (uint32_t i = 0; i < m_attempts && delayMs < max; ++i) {
+    delayMs *= m_config.multiplier;
+  }
+  delayMs = std::min(delayMs, max);
+
+  if (m_attempts < UINT32_MAX) {
+    ++m_attempts;
+  }
+
+  const auto jitterRange = static_cast<uint32_t>(delayMs * m_config.jitter);
+  if (jitterRange == 0) {
+    return std::chrono::milliseconds(static_cast<uint32_t>(delayMs));
+  }
+
+  // uniform in [delay - jitter, delay + jitter]
+  const auto offset = EspClass::random() % (2 * jitterRange + 1);
+  const auto result = static_cast<uint32_t>(delayMs) - jitterRange + offset;
+  return std::chrono::milliseconds(result);
+}
+
+}  // namespace esp_gui
@@ -0,0 +1,396 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/HeapProfiler.hpp>
+#include <esp-gui/RequestMetrics.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+namespace {
+enum class Dimension { GLOBAL, ROUTE, PHASE };
+
+struct Family {
+  const char* name;
+  const char* type;
+  const char* help;
+  Dimension dimension;
+  // samples per route or phase
+  size_t samples;
+};
+
+enum FamilyIndex {
+  HEAP_FREE,
+  HEAP_MIN_FREE,
+  HEAP_MAX_BLOCK,
+  HEAP_FRAGMENTATION,
+  REQUESTS,
+  RESPONSES,
+  RESPONSE_BYTES,
+  DURATION,
+  IN_FLIGHT,
+  REJECTED,
+  PHASE_RUNS,
+  PHASE_RETAINED,
+  PHASE_MAX_RETAINED,
+  PHASE_PEAK,
+  PHASE_MAX_PEAK,
+  PHASE_MIN_MAX_BLOCK,
+};
+}  // namespace
+
+size_t RequestMetrics::addRoute(const String& uri) {
+  for (size_t i = 0; i < m_routeCount; ++i) {
+    if (m_routes[i].uri == uri) {
+      return i;
+    }
+  }
+
+  // the last slot collects all routes which do not fit, names are never changed
+  if (m_routeCount == s_maxRoutes - 1) {
+    m_logger.log(
+      yal::Level::WARNING,
+      "Route table full, % and later routes share 'other', raise ESP_GUI_APP_ROUTES",
+      uri.c_str());
+    m_routes[m_routeCount++].uri = "other";
+  }
+  if (m_routeCount == s_maxRoutes) {
+    return s_maxRoutes - 1;
+  }
+
+  m_routes[m_routeCount].uri = uri;
+  return m_routeCount++;
+}
+
+void RequestMetrics::begin(size_t route) {
+  m_currentRoute = route;
+  m_currentStart = millis();
+  m_metered = false;
+  ++m_routes[route].requests;
+  sampleHeap();
+}
+
+void RequestMetrics::end() {
+  sampleHeap();
+  if (!m_metered) {
+    recordDuration(m_routes[m_currentRoute], millis() - m_currentStart);
+  }
+}
+
+void RequestMetrics::responded(
+  size_t route,
+  int code,
+  size_t bytes,
+  unsigned long durationMillis) {
+  auto& entry = m_routes[route];
+  const auto codeClass = static_cast<size_t>(code / 100);
+  if (codeClass >= 1 && codeClass <= s_codeClasses) {
+    ++entry.codes[codeClass - 1];
+  }
+  entry.bytes += bytes;
+  if (entry.inFlight > 0) {
+    --entry.inFlight;
+  }
+  recordDuration(entry, durationMillis);
+  sampleHeap();
+}
+
+void RequestMetrics::sampleHeap() {
+  m_minFreeHeap = std::min(m_minFreeHeap, EspClass::getFreeHeap());
+}
+
+void RequestMetrics::recordDuration(Route& route, unsigned long durationMillis) {
+  route.durationSumMillis += durationMillis;
+  size_t bucket = 0;
+  while (
+    bucket < s_latencyBucketsMs.size() && durationMillis > s_latencyBucketsMs[bucket]) {
+    ++bucket;
+  }
+  ++route.buckets[bucket];
+}
+
+size_t RequestMetrics::render(uint8_t* buffer, size_t maxLen, RenderPosition& position)
+  const {
+  size_t written = 0;
+  while (written < maxLen) {
+    if (position.offset == 0) {
+      auto& text = position.text;
+      const auto len = formatLine(position.line, text.data(), text.size());
+      if (len < 0) {
+        break;
+      }
+      position.length = std::min(static_cast<size_t>(len), position.text.size() - 1);
+    }
+
+    const auto chunk = std::min(position.length - position.offset, maxLen - written);
+    memcpy(buffer + written, position.text.data() + position.offset, chunk);
+    written += chunk;
+    position.offset += chunk;
+    if (position.offset == position.length) {
+      ++position.line;
+      position.offset = 0;
+    }
+  }
+  return written;
+}
+
+int RequestMetrics::formatLine(size_t line, char* out, size_t size) const {
+  static const Family families[] = {
+    {"esp_gui_heap_free_bytes", "gauge", "Free heap", Dimension::GLOBAL, 1},
+    {"esp_gui_heap_min_free_bytes",
+     "gauge",
+     "Lowest free heap seen by requests",
+     Dimension::GLOBAL,
+     1},
+    {"esp_gui_heap_max_free_block_bytes",
+     "gauge",
+     "Largest allocatable block",
+     Dimension::GLOBAL,
+     1},
+    {"esp_gui_heap_fragmentation_percent",
+     "gauge",
+     "Heap fragmentation",
+     Dimension::GLOBAL,
+     1},
+    {"esp_gui_http_requests_total", "counter", "Requests per route", Dimension::ROUTE, 1},
+    {"esp_gui_http_responses_total",
+     "counter",
+     "Responses per route and status class",
+     Dimension::ROUTE,
+     s_codeClasses},
+    {"esp_gui_http_response_bytes_total",
+     "counter",
+     "Bytes sent per route",
+     Dimension::ROUTE,
+     1},
+    {"esp_gui_http_request_duration_seconds",
+     "histogram",
+     "Time until the response was sent",
+     Dimension::ROUTE,
+     s_buckets + 2},
+    {"esp_gui_http_in_flight",
+     "gauge",
+     "Responses being sent per route",
+     Dimension::ROUTE,
+     1},
+    {"esp_gui_http_rejected_total",
+     "counter",
+     "Requests shed by the admission control per route",
+     Dimension::ROUTE,
+     1},
+    {"esp_gui_heap_phase_runs_total",
+     "counter",
+     "Profiled runs per phase",
+     Dimension::PHASE,
+     1},
+    {"esp_gui_heap_phase_retained_bytes",
+     "gauge",
+     "Heap still allocated after the last run",
+     Dimension::PHASE,
+     1},
+    {"esp_gui_heap_phase_max_retained_bytes",
+     "gauge",
+     "Most heap still allocated after a run",
+     Dimension::PHASE,
+     1},
+    {"esp_gui_heap_phase_peak_bytes",
+     "gauge",
+     "Peak heap usage of the last run",
+     Dimension::PHASE,
+     1},
+    {"esp_gui_heap_phase_max_peak_bytes",
+     "gauge",
+     "Highest peak heap usage of a run",
+     Dimension::PHASE,
+     1},
+    {"esp_gui_heap_phase_min_max_block_bytes",
+     "gauge",
+     "Smallest largest free block after a run",
+     Dimension::PHASE,
+     1},
+  };
+
+  for (size_t index = 0; index < sizeof(families) / sizeof(families[0]); ++index) {
+    const auto& family = families[index];
+    size_t entries = 1;
+    if (family.dimension == Dimension::ROUTE) {
+      entries = m_routeCount;
+    } else if (family.dimension == Dimension::PHASE) {
+      entries = HeapProfiler::phaseCount();
+    }
+
+    const auto samples = family.samples * entries;
+    if (line >= samples + 2) {
+      line -= samples + 2;
+      continue;
+    }
+
+    if (line == 0) {
+      return snprintf(out, size, "# HELP %s %s\n", family.name, family.help);
+    }
+    if (line == 1) {
+      return snprintf(out, size, "# TYPE %s %s\n", family.name, family.type);
+    }
+
+    const auto sample = line - 2;
+    if (family.dimension == Dimension::ROUTE) {
+      return formatRouteLine(
+        index, sample / family.samples, sample % family.samples, out, size);
+    }
+    if (family.dimension == Dimension::PHASE) {
+      return formatPhaseLine(index, family.name, sample, out, size);
+    }
+
+    uint32_t value = 0;
+    if (index == HEAP_FREE) {
+      value = EspClass::getFreeHeap();
+    } else if (index == HEAP_MIN_FREE) {
+      value = m_minFreeHeap;
+    } else if (index == HEAP_MAX_BLOCK) {
+      value = HeapProfiler::maxFreeBlock();
+    } else {
+      value = HeapProfiler::fragmentation();
+    }
+    return snprintf(out, size, "%s %u\n", family.name, static_cast<unsigned>(value));
+  }
+  return -1;
+}
+
+int RequestMetrics::formatPhaseLine(
+  size_t family,
+  const char* name,
+  size_t phase,
+  char* out,
+  size_t size) {
+  const auto& entry = HeapProfiler::phase(phase);
+  int32_t value = 0;
+  switch (family) {
+    case PHASE_RUNS:
+      value = static_cast<int32_t>(entry.runs);
+      break;
+    case PHASE_RETAINED:
+      value = entry.lastRetained;
+      break;
+    case PHASE_MAX_RETAINED:
+      value = entry.maxRetained;
+      break;
+    case PHASE_PEAK:
+      value = static_cast<int32_t>(entry.lastPeak);
+      break;
+    case PHASE_MAX_PEAK:
+      value = static_cast<int32_t>(entry.maxPeak);
+      break;
+    default:
+      value = static_cast<int32_t>(entry.minMaxBlock);
+      break;
+  }
+  return snprintf(
+    out, size, "%s{phase=\"%s\"} %d\n", name, entry.name, static_cast<int>(value));
+}
+
+int RequestMetrics::formatRouteLine(
+  size_t family,
+  size_t route,
+  size_t sample,
+  char* out,
+  size_t size) const {
+  const auto& entry = m_routes[route];
+  const auto* uri = entry.uri.c_str();
+
+  switch (family) {
+    case REQUESTS:
+      return snprintf(
+        out,
+        size,
+        "esp_gui_http_requests_total{route=\"%s\"} %u\n",
+        uri,
+        static_cast<unsigned>(entry.requests));
+
+    case RESPONSES:
+      if (entry.codes[sample] == 0) {
+        return 0;
+      }
+      return snprintf(
+        out,
+        size,
+        "esp_gui_http_responses_total{route=\"%s\",code=\"%uxx\"} %u\n",
+        uri,
+        static_cast<unsigned>(sample + 1),
+        static_cast<unsigned>(entry.codes[sample]));
+
+    case RESPONSE_BYTES:
+      return snprintf(
+        out,
+        size,
+        "esp_gui_http_response_bytes_total{route=\"%s\"} %u\n",
+        uri,
+        static_cast<unsigned>(entry.bytes));
+
+    case IN_FLIGHT:
+      return snprintf(
+        out,
+        size,
+        "esp_gui_http_in_flight{route=\"%s\"} %u\n",
+        uri,
+        static_cast<unsigned>(entry.inFlight));
+
+    case REJECTED:
+      return snprintf(
+        out,
+        size,
+        "esp_gui_http_rejected_total{route=\"%s\"} %u\n",
+        uri,
+        static_cast<unsigned>(entry.rejected));
+
+    case DURATION:
+      break;
+
+    default:
+      return 0;
+  }
+
+  // buckets are cumulative, sum and count include all requests
+  uint32_t count = 0;
+  for (size_t i = 0; i <= std::min(sample, s_buckets - 1); ++i) {
+    count += entry.buckets[i];
+  }
+
+  if (sample < s_latencyBucketsMs.size()) {
+    const auto bound = s_latencyBucketsMs[sample];
+    return snprintf(
+      out,
+      size,
+      "esp_gui_http_request_duration_seconds_bucket{route=\"%s\",le=\"%u.%03u\"} %u\n",
+      uri,
+      static_cast<unsigned>(bound / 1000),
+      static_cast<unsigned>(bound % 1000),
+      static_cast<unsigned>(count));
+  }
+  if (sample == s_latencyBucketsMs.size()) {
+    return snprintf(
+      out,
+      size,
+      "esp_gui_http_request_duration_seconds_bucket{route=\"%s\",le=\"+Inf\"} %u\n",
+      uri,
+      static_cast<unsigned>(count));
+  }
+  if (sample == s_buckets) {
+    return snprintf(
+      out,
+      size,
+      "esp_gui_http_request_duration_seconds_sum{route=\"%s\"} %u.%03u\n",
+      uri,
+      static_cast<unsigned>(entry.durationSumMillis / 1000),
+      static_cast<unsigned>(entry.durationSumMillis % 1000));
+  }
+  return snprintf(
+    out,
+    size,
+    "esp_gui_http_request_duration_seconds_count{route=\"%s\"} %u\n",
+    uri,
+    static_cast<unsigned>(count));
+}
+
+}  // namespace esp_gui
@@ -7,61 +7,139 @@
 
 namespace esp_gui {
 
+static const char s_uploadConfigName[] PROGMEM = "updateFirmware";
+static const char s_deltaConfigName[] PROGMEM = "updateFirmwareDelta";
+static const char s_fileSystemConfigName[] PROGMEM = "updateFileSystem";
+
 void UpdateManager::setup() {
-  Container update("Update");
+  m_pipeline->add<DigestStage>();
+  m_sink = &m_pipeline->add<OtaSink>(U_FLASH);
+
+  m_deltaPipeline->add<DeltaStage>();
+  m_deltaPipeline->add<DigestStage>();
+  m_deltaSink = &m_deltaPipeline->add<OtaSink>(U_FLASH, false);
+
+  m_fileSystemPipeline->add<DigestStage>();
+  m_fileSystemSink = &m_fileSystemPipeline->add<OtaSink>(U_FS);
+
+  Container update(F("Update"));
   update.addUpload(
-    "Upload",
-    "Update",
-    m_uploadConfigName,
-    ".bin,.bin.gz",
-    [&](
-      AsyncWebServerRequest* request,
-      const String& filename,
-      size_t index,
-      uint8_t* data,
-      size_t len,
-      bool final) { onUpload(request, filename, index, data, len, final); },
-    [&](AsyncWebServerRequest* request) { onPost(request); });
+    F("Upload"),
+    F("Update"),
+    FPSTR(s_uploadConfigName),
+    F(".bin,.bin.gz"),
+    m_pipeline,
+    [&](AsyncWebServerRequest* request) { onPost(request, *m_pipeline); });
+  update.addUpload(
+    F("Patch"),
+    F("Apply patch"),
+    FPSTR(s_deltaConfigName),
+    F(".delta"),
+    m_deltaPipeline,
+    [&](AsyncWebServerRequest* request) { onPost(request, *m_deltaPipeline); });
+  update.addUpload(
+    F("File system"),
+    F("Update file system"),
+    FPSTR(s_fileSystemConfigName),
+    F(".bin"),
+    m_fileSystemPipeline,
+    [&](AsyncWebServerRequest* request) { onFileSystemPost(request); });
   m_webServer.addContainer(std::move(update));
+
+  m_webServer.on(
+    "/update/progress",
+    HTTP_GET,
+    [this](AsyncWebServerRequest* request) { onProgress(request); },
+    AdmissionControl::RouteClass::PROBE);
 }
 
-void UpdateManager::onUpload(
-  AsyncWebServerRequest* request,
-  const String& filename,
-  size_t index,
-  uint8_t* data,
-  size_t len,
-  bool final) {
-  if (!index) {
-    m_logger.log(yal::Level::INFO, "Starting update with file: %", filename.c_str());
-
-    Update.runAsync(true);
-    if (!Update.begin((EspClass::getFreeSketchSpace() - 0x1000) & 0xFFFFF000)) {
-      Update.printError(Serial);
-    }
+void UpdateManager::loop() {
+  m_pipeline->loop();
+  m_deltaPipeline->loop();
+  m_fileSystemPipeline->loop();
+
+  // a failed update leaves a partially written file system as well
+  const auto fileSystemState = m_fileSystemSink->ota().state();
+  if (
+    m_fileSystemState == OtaPipeline::State::RECEIVING &&
+    fileSystemState != OtaPipeline::State::RECEIVING) {
+    m_webServer.reloadFileSystem();
   }
+  m_fileSystemState = fileSystemState;
 
-  if (!Update.hasError()) {
-    if (Update.write(data, len) != len) {
-      Update.printError(Serial);
-    }
+  if (m_pendingPipeline == nullptr || m_pendingPipeline->busy()) {
+    return;
   }
 
-  if (final) {
-    if (Update.end(true)) {
-      m_logger.log(yal::Level::INFO, "Update success, filesize: %", index + len);
-    } else {
-      Update.printError(Serial);
-    }
+  if (m_pendingPipeline->succeeded()) {
+    m_logger.log(yal::Level::WARNING, "Patch applied, restarting");
+    EspClass::restart();
   }
+  m_logger.log(yal::Level::ERROR, "Update failed: %", m_pendingPipeline->error());
+  m_pendingPipeline = nullptr;
 }
 
-void UpdateManager::onPost(AsyncWebServerRequest* request) {
-  const bool updateSuccess = !Update.hasError();
+void UpdateManager::onFileSystemPost(AsyncWebServerRequest* request) {
+  if (!m_fileSystemPipeline->succeeded()) {
+    onPost(request, *m_fileSystemPipeline);
+    return;
+  }
+
+  // configuration and html index are reloaded from loop(), no restart needed
+  m_logger.log(yal::Level::INFO, "File system updated");
+  m_webServer.redirectBackToHome(request, 5s);
+}
+
+void UpdateManager::onPost(AsyncWebServerRequest* request, UploadPipeline& pipeline) {
+  if (pipeline.busy()) {
+    // the result is reported by /update/progress, loop() restarts on success
+    m_pendingPipeline = &pipeline;
+    m_webServer.redirectBackToHome(request, 30s);
+    return;
+  }
+
+  if (!pipeline.succeeded()) {
+    // keep running the current firmware, a reboot would not change anything
+    const auto* error = pipeline.error();
+    const String reason = error != nullptr ? error : "unknown error";
+    m_logger.log(yal::Level::ERROR, "Update failed: %", reason.c_str());
+    m_webServer.send(
+      request, HTTP_BAD_REQUEST, "text/plain", "Update failed: " + reason);
+    return;
+  }
+
   m_webServer.redirectBackToHome(request, 30s);
+  m_webServer.reset(request, "Update success");
+}
+
+const OtaPipeline& UpdateManager::activeOta() const {
+  const std::array<const OtaSink*, 3> sinks = {m_sink, m_deltaSink, m_fileSystemSink};
+  for (const auto* sink : sinks) {
+    if (sink->ota().state() == OtaPipeline::State::RECEIVING) {
+      return sink->ota();
+    }
+  }
+  for (const auto* sink : sinks) {
+    if (sink->ota().state() != OtaPipeline::State::IDLE) {
+      return sink->ota();
+    }
+  }
+  return m_sink->ota();
+}
+
+void UpdateManager::onProgress(AsyncWebServerRequest* request) {
+  static const char* const states[] = {"idle", "receiving", "finished", "failed"};
 
-  m_webServer.reset(
-    request, (String("Update ") + (updateSuccess ? "success" : "failed")).c_str());
+  const auto& ota = activeOta();
+  AsyncResponseStream* response = request->beginResponseStream("application/json");
+  response->printf(
+    R"({"state":"%s","received":%u,"written":%u,"elapsed_ms":%lu,"bytes_per_second":%u})",
+    states[static_cast<int>(ota.state())],
+    ota.received(),
+    ota.written(),
+    ota.elapsedMillis(),
+    ota.bytesPerSecond());
+  m_webServer.send(request, HTTP_OK, response);
 }
 
 }  // namespace esp_gui
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/UploadPipeline.hpp>
+
+namespace esp_gui {
+
+void UploadPipeline::onUpload(
+  AsyncWebServerRequest* request,
+  const String& filename,
+  size_t index,
+  uint8_t* data,
+  size_t len,
+  bool final) {
+  if (m_stages.empty()) {
+    return;
+  }
+  auto& first = *m_stages.front();
+
+  if (!index) {
+    m_logger.log(yal::Level::INFO, "Receiving upload %", filename.c_str());
+    for (auto& stage : m_stages) {
+      stage->setError(nullptr);
+    }
+    m_state = State::RECEIVING;
+    request->onDisconnect([this]() {
+      m_stages.front()->disconnected();
+      if (m_state == State::RECEIVING) {
+        m_logger.log(yal::Level::WARNING, "Client disconnected during upload");
+        m_state = State::FAILED;
+        m_stages.front()->abort();
+      }
+    });
+
+    if (!first.begin(request, filename)) {
+      fail(request, true);
+      return;
+    }
+  }
+
+  if (m_state != State::RECEIVING) {
+    return;
+  }
+
+  if (len > 0 && !first.write(data, len)) {
+    fail(request, true);
+    return;
+  }
+
+  if (!final) {
+    return;
+  }
+
+  if (!first.end()) {
+    fail(request, false);
+    return;
+  }
+
+  m_state = State::FINISHED;
+  m_logger.log(yal::Level::INFO, "Upload finished, % bytes", index + len);
+}
+
+void UploadPipeline::loop() {
+  if (m_state == State::RECEIVING || m_state == State::FINISHED) {
+    if (!m_stages.empty()) {
+      m_stages.front()->loop();
+    }
+  }
+}
+
+const char* UploadPipeline::error() const {
+  if (m_stages.empty()) {
+    return nullptr;
+  }
+
+  const auto* error = m_stages.front()->error();
+  if (error == nullptr && m_state == State::FAILED) {
+    return "upload failed";
+  }
+  return error;
+}
+
+String UploadPipeline::requestValue(
+  AsyncWebServerRequest* request,
+  const String& header,
+  const char* field) {
+  if (request->hasHeader(header)) {
+    return request->getHeader(header)->value();
+  }
+
+  // form fields are only known if they are sent before the file
+  if (request->hasParam(field, true)) {
+    return request->getParam(field, true)->value();
+  }
+  return String();
+}
+
+void UploadPipeline::fail(AsyncWebServerRequest* request, bool closeConnection) {
+  m_state = State::FAILED;
+  m_logger.log(yal::Level::ERROR, "Upload failed: %", error());
+  m_stages.front()->abort();
+
+  if (closeConnection) {
+    // closes after the current packet was processed, stops the transfer early
+    request->client()->close();
+  }
+}
+
+}  // namespace esp_gui
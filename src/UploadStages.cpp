@@ -0,0 +1,224 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <Updater.h>
+#include <esp-gui/UploadStages.hpp>
+
+extern "C" uint32_t _FS_start;
+extern "C" uint32_t _FS_end;
+
+namespace esp_gui {
+
+bool SizeLimitStage::begin(AsyncWebServerRequest* request, const String& filename) {
+  m_size = 0;
+  return UploadStage::begin(request, filename);
+}
+
+bool SizeLimitStage::write(const uint8_t* data, size_t len) {
+  m_size += len;
+  if (m_size > m_maxSize) {
+    setError("upload too large");
+    return false;
+  }
+  return UploadStage::write(data, len);
+}
+
+bool DigestStage::begin(AsyncWebServerRequest* request, const String& filename) {
+  const String prefix(m_headerPrefix);
+  const auto expectedSize = static_cast<size_t>(
+    UploadPipeline::requestValue(request, prefix + "Size", "size").toInt());
+  if (!m_verifier.begin(
+        expectedSize,
+        UploadPipeline::requestValue(request, prefix + "MD5", "md5"),
+        UploadPipeline::requestValue(request, prefix + "SHA256", "sha256"))) {
+    setError(m_verifier.error());
+    return false;
+  }
+  return UploadStage::begin(request, filename);
+}
+
+bool DigestStage::write(const uint8_t* data, size_t len) {
+  if (!m_verifier.update(data, len)) {
+    setError(m_verifier.error());
+    return false;
+  }
+  return UploadStage::write(data, len);
+}
+
+bool DigestStage::end() {
+  // verify before the sink commits the data
+  if (!m_verifier.finish()) {
+    setError(m_verifier.error());
+    return false;
+  }
+  return UploadStage::end();
+}
+
+bool GzipMagicStage::begin(AsyncWebServerRequest* request, const String& filename) {
+  m_headerSize = 0;
+  return UploadStage::begin(request, filename);
+}
+
+bool GzipMagicStage::write(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && m_headerSize < m_header.size(); ++i) {
+    m_header[m_headerSize++] = data[i];
+    if (m_headerSize == m_header.size()) {
+      // magic bytes and deflate compression method
+      if (m_header[0] != 0x1f || m_header[1] != 0x8b || m_header[2] != 8) {
+        setError("not a gzip file");
+        return false;
+      }
+    }
+  }
+  return UploadStage::write(data, len);
+}
+
+bool OtaSink::begin(AsyncWebServerRequest* request, const String& filename) {
+  size_t maxSize = 0;
+  if (m_command == U_FS) {
+    maxSize = reinterpret_cast<size_t>(&_FS_end) - reinterpret_cast<size_t>(&_FS_start);
+  } else {
+    maxSize = (EspClass::getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
+  }
+
+  // with a known size the updater only erases what is needed
+  const auto expectedSize = static_cast<size_t>(
+    UploadPipeline::requestValue(request, "X-Update-Size", "size").toInt());
+  if (expectedSize > maxSize) {
+    setError("image does not fit into flash");
+    return false;
+  }
+
+  if (m_command == U_FS) {
+    // the image replaces the mounted file system, the lock unmounts it
+    Configuration::lockFileSystem(true);
+  }
+
+  m_magicSize = 0;
+  const auto size = expectedSize != 0 ? expectedSize : maxSize;
+  auto* client = m_throttle ? request->client() : nullptr;
+  if (!m_ota.begin(size, m_command, client)) {
+    if (m_command == U_FS) {
+      Configuration::lockFileSystem(false);
+    }
+    setError("failed to start update");
+    return false;
+  }
+  return UploadStage::begin(request, filename);
+}
+
+bool OtaSink::write(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && m_magicSize < m_magic.size(); ++i) {
+    m_magic[m_magicSize++] = data[i];
+    if (m_magicSize == m_magic.size() && m_magic[0] == 0x1f && m_magic[1] == 0x8b) {
+      // nothing inflates the image, it would be written compressed
+      setError("gzip compressed images are not supported");
+      return false;
+    }
+  }
+
+  if (!m_ota.write(data, len)) {
+    setError("flash write failed");
+    return false;
+  }
+  return UploadStage::write(data, len);
+}
+
+bool OtaSink::end() {
+  const auto success = m_ota.end();
+  if (m_command == U_FS) {
+    Configuration::lockFileSystem(false);
+  }
+  if (!success) {
+    setError("finalizing update failed");
+    return false;
+  }
+  return UploadStage::end();
+}
+
+void OtaSink::abort() {
+  m_ota.abort();
+  if (m_command == U_FS) {
+    Configuration::lockFileSystem(false);
+  }
+  UploadStage::abort();
+}
+
+void OtaSink::disconnected() {
+  m_ota.clientDisconnected();
+  UploadStage::disconnected();
+}
+
+void OtaSink::loop() {
+  m_ota.loop();
+  UploadStage::loop();
+}
+
+bool FileSink::begin(AsyncWebServerRequest* request, const String& filename) {
+  m_tempPath = m_path + ".tmp";
+  m_size = 0;
+  m_file = std::make_unique<Configuration::FileHandle>(m_tempPath.c_str());
+  if (!m_file->open("w")) {
+    setError("failed to open file");
+    m_file.reset();
+    return false;
+  }
+  return UploadStage::begin(request, filename);
+}
+
+bool FileSink::write(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && m_size + i < m_magic.size(); ++i) {
+    m_magic[m_size + i] = data[i];
+  }
+  m_size += len;
+
+  if (!m_file || m_file->file().write(data, len) != len) {
+    setError("file write failed");
+    return false;
+  }
+  return UploadStage::write(data, len);
+}
+
+bool FileSink::end() {
+  if (!m_file) {
+    return false;
+  }
+  m_file->close();
+
+  String path = m_path;
+  const auto gzip = m_size >= m_magic.size() && m_magic[0] == 0x1f && m_magic[1] == 0x8b;
+  if (gzip && !path.endsWith(".gz")) {
+    path += ".gz";
+  }
+
+  // the file system is still mounted by the handle
+  LittleFS.remove(path);
+  const auto renamed = LittleFS.rename(m_tempPath, path);
+  m_file.reset();
+  if (!renamed) {
+    setError("failed to rename file");
+    return false;
+  }
+  return UploadStage::end();
+}
+
+void FileSink::abort() {
+  if (m_file) {
+    m_file->close();
+    LittleFS.remove(m_tempPath);
+    m_file.reset();
+  }
+  UploadStage::abort();
+}
+
+bool CallbackSink::write(const uint8_t* data, size_t len) {
+  if (m_onData && !m_onData(data, len)) {
+    setError("rejected by callback");
+    return false;
+  }
+  return UploadStage::write(data, len);
+}
+
+}  // namespace esp_gui
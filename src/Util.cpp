@@ -7,7 +7,9 @@
 void logMemory(const yal::Logger& logger) {
   logger.log(
     yal::Level::DEBUG,
-    "Free heap: %, free stack %",
+    "Free heap: %, max block %, fragmentation % percent, free stack %",
     EspClass::getFreeHeap(),
+    EspClass::getMaxFreeBlockSize(),
+    EspClass::getHeapFragmentation(),
     EspClass::getFreeContStack());
 }
@@ -5,22 +5,102 @@
 
 #include <ESP8266mDNS.h>
 #include <LittleFS.h>
+#include <esp-gui/HeapProfiler.hpp>
 #include <esp-gui/Util.hpp>
 #include <esp-gui/WebServer.hpp>
+#include <esp-gui/generated/WebAssets.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
 #include <functional>
 #include <string>
 #include <typeindex>
 
 namespace esp_gui {
 
-static const constexpr char* const s_htmlIndexStart PROGMEM =
-  R"(<!DOCTYPE html><html lang=en><title>%page_title%</title><meta charset=utf-8><meta content="width=device-width,user-scalable=no"name=viewport><style>html{background-color:#212121}p{font-weight:500}a:visited{text-decoration:none;color:#E0E0E0}a{text-decoration:none}*{margin:0;padding:0;color:#E0E0E0;overflow-x:hidden}body{font-size:16px;font-family:Roboto,sans-serif;font-weight:300;color:#4a4a4a}input,select{width:120px;background:#121212;border:none;border-radius:4px;padding-left:1rem;padding-right:1rem;height:50px;margin-bottom:.75em;font-size:.85rem;box-shadow:0 10px 20px rgba(0,0,0,.19),0 6px 6px rgba(0,0,0,.23)}.inputMedium{width:155px}.inputSmall{width:85px}.inputLarge{width:260px}.otherLarge{width:290px}label{margin-right:1em;font-size:1rem;display:inline-block;width:120px}.break{flex-basis:100%%;height:0}.btn{background:#303F9F;color:#EEE;border-radius:4px}.btnLarge{width:auto}.btnTop{margin-left:8px;margin-right:8px}.btnFlexContainer{width:290px}.flex-container{display:flex;flex-wrap:wrap}.flex-nav{flex-grow:1;flex-shrink:0;background:#303F9F;height:3rem}.featured{background:#3F51B5;color:#fff;padding:1em}.featured h1{font-size:2rem;margin-bottom:1rem;font-weight:300}.flex-card{overflow-y:hidden;flex:1;flex-shrink:0;flex-basis:400px;display:flex;flex-wrap:wrap;background:#212121;margin:.5rem;box-shadow:0 10px 20px rgba(0,0,0,.19),0 6px 6px rgba(0,0,0,.23)}.flex-card div{flex:100%%}.fit-content{height:fit-content}.flex-card .hero{position:relative;color:#fff;height:70px;background:linear-gradient(rgba(0,0,0,.5),rgba(0,0,0,.5)) no-repeat;background-size:cover}.flex-card .hero h3{position:absolute;bottom:15px;left:0;padding:0 1rem}.content{min-height:100%%;min-width:400px}.flex-card .content{color:#BDBDBD;padding:1.5rem 1rem 2rem 1rem}</style><div class=flex-container><div class=flex-nav></div></div><div class=featured><h1><a href=/ >%page_title%</a></h1></div><div><div style=margin-top:10px><form action=/eraseConfig enctype=multipart/form-data id=formEraseConfig method=POST></form><form action=/reboot enctype=multipart/form-data id=formReboot method=POST></form><form action=/ enctype=multipart/form-data id=formUpdateConfig method=POST></form><form action=/onClick enctype=multipart/form-data id=formOnClick method=POST></form></div><input class="btn btnLarge btnTop"form=formUpdateConfig type=submit value="Update settings"> <input class="btn btnLarge btnTop"form=formReboot type=submit value=Reboot> <input class="btn btnLarge btnTop"form=formEraseConfig type=submit value="Erase config"><div class="flex-container animated zoomIn">)";
-static const constexpr char* const s_htmlIndexEnd = R"(</div></div></body></html>)";
+static const constexpr char* const s_legacyHtmlIndex = "/index.html";
+static const char s_panelFieldHtml[] PROGMEM =
+  R"(<input type="hidden" name="__panel" value="%__panel%" form="formUpdateConfig">)";
 static const constexpr char* const s_htmlRedirectDelayed PROGMEM =
   R"(<html lang=en><style>html{background-color:#424242;font-size:16px;font-family:Roboto,sans-serif;font-weight:300;color:#fefefe;text-align:center}</style><meta content=%redirect_seconds%;/ http-equiv=refresh><h1>Reloading in %redirect_seconds% seconds...</h1>)";
+static const constexpr char* const s_serviceUnavailable PROGMEM =
+  "503 Service Unavailable";
 static const constexpr char* const s_htmlRedirectReset PROGMEM =
   R"(<html lang=en><style>html{background-color:#424242;font-size:16px;font-family:Roboto,sans-serif;font-weight:300;color:#fefefe;text-align:center}</style><meta content=%redirect_seconds%;/ http-equiv=refresh><h1>Resetting ESP8266</h1><h2>Reason:<h2><p>%s</p>)";
 
+// INT elements are stored as int32_t, DOUBLE elements as finite double
+static std::optional<int32_t> parseInt(const char* text) {
+  char* end = nullptr;
+  errno = 0;
+  const auto value = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || errno == ERANGE || value < INT32_MIN ||
+      value > INT32_MAX) {
+    return std::nullopt;
+  }
+  return static_cast<int32_t>(value);
+}
+
+static std::optional<double> parseDouble(const char* text) {
+  char* end = nullptr;
+  const auto value = strtod(text, &end);
+  if (end == text || *end != '\0' || !std::isfinite(value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+namespace {
+// keeps the bytes [offset, offset + size) of everything printed, lets a chunked
+// response serialize a document again for each chunk instead of buffering it
+class PrintWindow : public Print {
+ public:
+  PrintWindow(uint8_t* buffer, size_t size, size_t offset) :
+      m_buffer(buffer), m_size(size), m_offset(offset) {
+  }
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* data, size_t size) override {
+    const auto end = m_position + size;
+    if (end > m_offset && m_position < m_offset + m_size) {
+      const auto from = std::max(m_position, m_offset);
+      const auto to = std::min(end, m_offset + m_size);
+      memcpy(m_buffer + from - m_offset, data + from - m_position, to - from);
+    }
+    m_position = end;
+    return size;
+  }
+
+  [[nodiscard]] size_t length() const {
+    return m_position <= m_offset ? 0 : std::min(m_position - m_offset, m_size);
+  }
+
+ private:
+  uint8_t* const m_buffer;
+  const size_t m_size;
+  const size_t m_offset;
+  size_t m_position = 0;
+};
+}  // namespace
+
+static void printJsonString(Print& out, const String& text) {
+  out.print('"');
+  for (size_t i = 0; i < text.length(); ++i) {
+    const auto c = text[i];
+    if (c == '"' || c == '\\') {
+      out.print('\\');
+      out.print(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out.printf("\\u%04x", c);
+    } else {
+      out.print(c);
+    }
+  }
+  out.print('"');
+}
+
 void WebServer::setup(const String& hostname) {
   m_logger.log(
     yal::Level::DEBUG, "Setting up web server with hostname: %", hostname.c_str());
@@ -35,47 +115,158 @@ void WebServer::setup(const String& hostname) {
   MDNS.addService("http", "tcp", 80);
 
   const char* rootPath = "/";
+  using RouteClass = AdmissionControl::RouteClass;
+  m_rootRoute = m_metrics.addRoute(routeName(HTTP_GET, rootPath));
 
   m_asyncWebServer.on(
     rootPath,
     HTTP_POST,
-    std::bind(&WebServer::rootHandlePost, this, std::placeholders::_1));
+    instrument(
+      HTTP_POST,
+      rootPath,
+      RouteClass::ACTION,
+      std::bind(&WebServer::rootHandlePost, this, std::placeholders::_1)));
 
   m_asyncWebServer.on(
     "/eraseConfig",
     HTTP_POST,
-    std::bind(&WebServer::eraseConfig, this, std::placeholders::_1));
+    instrument(
+      HTTP_POST,
+      "/eraseConfig",
+      RouteClass::ACTION,
+      std::bind(&WebServer::eraseConfig, this, std::placeholders::_1)));
 
   m_asyncWebServer.on(
-    "/onClick", HTTP_POST, std::bind(&WebServer::onClick, this, std::placeholders::_1));
+    "/onClick",
+    HTTP_POST,
+    instrument(
+      HTTP_POST,
+      "/onClick",
+      RouteClass::ACTION,
+      std::bind(&WebServer::onClick, this, std::placeholders::_1)));
 
-  m_asyncWebServer.on("/reboot", HTTP_POST, [this](AsyncWebServerRequest* request) {
-    reset(request, "User requested reboot");
-  });
+  m_asyncWebServer.on(
+    "/config/export",
+    HTTP_GET,
+    instrument(
+      HTTP_GET,
+      "/config/export",
+      RouteClass::PROBE,
+      std::bind(&WebServer::onConfigExport, this, std::placeholders::_1)));
 
-  m_asyncWebServer.onNotFound(
-    std::bind(&WebServer::onNotFound, this, std::placeholders::_1));
+  m_asyncWebServer.on(
+    "/config/import",
+    HTTP_POST,
+    instrument(
+      HTTP_POST,
+      "/config/import",
+      RouteClass::ACTION,
+      std::bind(&WebServer::onConfigImport, this, std::placeholders::_1)),
+    nullptr,
+    [this](
+      AsyncWebServerRequest* request,
+      uint8_t* data,
+      size_t len,
+      size_t index,
+      size_t total) { onConfigImportBody(request, data, len, index, total); });
 
-  m_asyncWebServer.on(rootPath, HTTP_GET, [this](AsyncWebServerRequest* request) {
-    if (!isCaptivePortal(request)) {
-      rootHandleGet(request);
-    }
-  });
+  m_asyncWebServer.on(
+    "/reboot",
+    HTTP_POST,
+    instrument(
+      HTTP_POST, "/reboot", RouteClass::CONTROL, [this](AsyncWebServerRequest* request) {
+        reset(request, "User requested reboot");
+      }));
 
-  m_asyncWebServer.on(rootPath, HTTP_GET, [this](AsyncWebServerRequest* request) {
-    if (!isCaptivePortal(request)) {
-      rootHandleGet(request);
-    }
-  });
+  m_asyncWebServer.on(
+    "/metrics",
+    HTTP_GET,
+    instrument(
+      HTTP_GET,
+      "/metrics",
+      RouteClass::PROBE,
+      std::bind(&WebServer::onMetrics, this, std::placeholders::_1)));
+
+  m_asyncWebServer.onNotFound(instrument(
+    HTTP_ANY,
+    "not_found",
+    RouteClass::PROBE,
+    std::bind(&WebServer::onNotFound, this, std::placeholders::_1)));
 
   m_asyncWebServer.on(
-    s_redirectDelayedURL, HTTP_GET, [this](AsyncWebServerRequest* request) {
-      request->send_P(
-        HTTP_OK,
-        CONTENT_TYPE_HTML,
-        s_htmlRedirectDelayed,
-        [&](const String& templateString) { return String(m_redirectDelay.count()); });
-    });
+    rootPath,
+    HTTP_GET,
+    instrument(
+      HTTP_GET, rootPath, RouteClass::PAGE, [this](AsyncWebServerRequest* request) {
+        if (!isCaptivePortal(request)) {
+          rootHandleGet(request);
+        }
+      }));
+
+  m_asyncWebServer.on(
+    "/panel",
+    HTTP_GET,
+    instrument(
+      HTTP_GET, "/panel", RouteClass::PAGE, [this](AsyncWebServerRequest* request) {
+        if (!isCaptivePortal(request)) {
+          onPanel(request);
+        }
+      }));
+
+  m_asyncWebServer.on(
+    "/options",
+    HTTP_GET,
+    instrument(
+      HTTP_GET,
+      "/options",
+      RouteClass::PROBE,
+      std::bind(&WebServer::onOptions, this, std::placeholders::_1)));
+
+  m_asyncWebServer.on(
+    "/style.css",
+    HTTP_GET,
+    instrument(
+      HTTP_GET, "/style.css", RouteClass::PROBE, [this](AsyncWebServerRequest* request) {
+        sendAsset(
+          request,
+          "text/css",
+          assets::s_styleGzip,
+          assets::s_styleGzipLength,
+          assets::s_styleETag);
+      }));
+
+  m_asyncWebServer.on(
+    "/options.js",
+    HTTP_GET,
+    instrument(
+      HTTP_GET, "/options.js", RouteClass::PROBE, [this](AsyncWebServerRequest* request) {
+        sendAsset(
+          request,
+          "text/javascript",
+          assets::s_optionsScriptGzip,
+          assets::s_optionsScriptGzipLength,
+          assets::s_optionsScriptETag);
+      }));
+
+  m_asyncWebServer.on(
+    s_redirectDelayedURL,
+    HTTP_GET,
+    instrument(
+      HTTP_GET,
+      s_redirectDelayedURL,
+      RouteClass::PROBE,
+      [this](AsyncWebServerRequest* request) {
+        send(
+          request,
+          HTTP_OK,
+          request->beginResponse_P(
+            HTTP_OK,
+            CONTENT_TYPE_HTML,
+            s_htmlRedirectDelayed,
+            [&](const String& templateString) {
+              return String(m_redirectDelay.count());
+            }));
+      }));
 
   m_asyncWebServer.begin();
   m_logger.log(yal::Level::DEBUG, "Web server ready");
@@ -85,28 +276,445 @@ void WebServer::addContainer(Container&& container) {
   m_container.push_back(container);
 }
 
+void WebServer::on(
+  const char* uri,
+  WebRequestMethodComposite method,
+  ArRequestHandlerFunction&& handler,
+  AdmissionControl::RouteClass routeClass) {
+  m_asyncWebServer.on(
+    uri, method, instrument(method, uri, routeClass, std::move(handler)));
+}
+
+String WebServer::routeName(WebRequestMethodComposite method, const String& uri) {
+  switch (method) {
+    case HTTP_GET:
+      return "GET " + uri;
+    case HTTP_POST:
+      return "POST " + uri;
+    default:
+      return uri;
+  }
+}
+
+ArRequestHandlerFunction WebServer::instrument(
+  WebRequestMethodComposite method,
+  const String& uri,
+  AdmissionControl::RouteClass routeClass,
+  ArRequestHandlerFunction&& handler) {
+  const auto index = m_metrics.addRoute(routeName(method, uri));
+  m_admission.addRoute(index, routeClass);
+  return [this, index, handler = std::move(handler)](AsyncWebServerRequest* request) {
+    HeapProfiler::Scope profile(m_metrics.routeName(index));
+    m_metrics.begin(index);
+
+    // uploads are admitted on their first chunk, the data is already stored here
+    const char* reason = nullptr;
+    if (m_admission.routeClass(index) != AdmissionControl::RouteClass::UPLOAD) {
+      reason = m_admission.admit(index, m_metrics);
+    }
+
+    if (reason == nullptr) {
+      handler(request);
+    } else {
+      m_metrics.rejected(index);
+      reject(request, index, reason);
+    }
+    m_metrics.end();
+  };
+}
+
+void WebServer::reject(AsyncWebServerRequest* request, size_t route, const char* reason) {
+  m_logger.log(
+    yal::Level::DEBUG, "Rejecting request of %: %", m_metrics.routeName(route), reason);
+
+  auto* response = request->beginResponse_P(
+    HTTP_SERVICE_UNAVAILABLE, "text/plain", s_serviceUnavailable);
+  response->addHeader("Retry-After", String(m_admission.retryAfter()));
+  send(request, HTTP_SERVICE_UNAVAILABLE, response);
+}
+
+void WebServer::send(
+  AsyncWebServerRequest* request,
+  int code,
+  AsyncWebServerResponse* response) {
+  request->send(new MeteredResponse(m_metrics, code, response));
+}
+
+void WebServer::send(
+  AsyncWebServerRequest* request,
+  int code,
+  const String& contentType,
+  const String& content) {
+  send(request, code, request->beginResponse(code, contentType, content));
+}
+
+void WebServer::onMetrics(AsyncWebServerRequest* request) {
+  m_metrics.sampleHeap();
+  auto position = std::make_shared<RequestMetrics::RenderPosition>();
+  send(
+    request,
+    HTTP_OK,
+    request->beginChunkedResponse(
+      "text/plain; version=0.0.4",
+      [this, position](uint8_t* buffer, size_t maxLen, size_t index) {
+        return m_metrics.render(buffer, maxLen, *position);
+      }));
+}
+
+void WebServer::sendAsset(
+  AsyncWebServerRequest* request,
+  const char* contentType,
+  const uint8_t* data,
+  size_t length,
+  PGM_P etagInFlash) {
+  const String etag = FPSTR(etagInFlash);
+  if (notModified(request, etag)) {
+    return;
+  }
+
+  auto* response = request->beginResponse_P(HTTP_OK, contentType, data, length);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  send(request, HTTP_OK, response);
+}
+
+bool WebServer::notModified(AsyncWebServerRequest* request, const String& etag) {
+  if (!request->hasHeader("If-None-Match") || request->header("If-None-Match") != etag) {
+    return false;
+  }
+
+  auto* response = request->beginResponse(HTTP_NOT_MODIFIED);
+  response->addHeader("ETag", etag);
+  send(request, HTTP_NOT_MODIFIED, response);
+  return true;
+}
+
+void WebServer::onOptions(AsyncWebServerRequest* request) {
+  const auto param = [request](const char* name, long defaultValue) {
+    return request->hasParam(name) ? request->getParam(name)->value().toInt()
+                                   : defaultValue;
+  };
+
+  const auto name =
+    request->hasParam("name") ? request->getParam("name")->value() : String();
+  const ChoiceElementBase* choice = findElement<ListElement>(name);
+  if (choice == nullptr) {
+    choice = findElement<DropDownElement>(name);
+  }
+  if (choice == nullptr) {
+    send(request, HTTP_NOT_FOUND, "application/json", "{}");
+    return;
+  }
+
+  const auto offset = std::max(param("offset", 0), 0L);
+  const auto limit =
+    std::min(std::max(param("limit", s_defaultOptionLimit), 0L), s_maxOptionLimit);
+  const auto prefix =
+    request->hasParam("prefix") ? request->getParam("prefix")->value() : String();
+
+  // only the requested page is copied, the other options are just counted
+  auto* response = request->beginResponseStream("application/json");
+  response->print(R"({"options":[)");
+  long total = 0;
+  for (const auto& option : choice->options()) {
+    if (!option.startsWith(prefix)) {
+      continue;
+    }
+    if (total >= offset && total < offset + limit) {
+      if (total > offset) {
+        response->print(',');
+      }
+      printJsonString(*response, option.toString());
+    }
+    ++total;
+  }
+  response->printf(R"(],"total":%ld})", total);
+  send(request, HTTP_OK, response);
+}
+
+void WebServer::onConfigExport(AsyncWebServerRequest* request) {
+  const auto secrets =
+    request->hasParam("secrets") && request->getParam("secrets")->value() == "1";
+  const auto version = m_config.version();
+  auto* response = request->beginChunkedResponse(
+    "application/json",
+    [this, secrets, version](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+      // each chunk serializes the configuration again, a change in between would
+      // mix two versions. The truncated json is rejected by an import.
+      if (m_config.version() != version) {
+        m_logger.log(yal::Level::WARNING, "Configuration changed during export");
+        return 0;
+      }
+      PrintWindow window(buffer, maxLen, index);
+      exportConfig(window, secrets);
+      return window.length();
+    });
+  response->addHeader(
+    "Content-Disposition", R"(attachment; filename="esp-gui-config.json")");
+  send(request, HTTP_OK, response);
+}
+
+void WebServer::exportConfig(Print& out, bool secrets) {
+  out.print('{');
+  auto first = true;
+  for (const auto& kv : m_config.values()) {
+    const String key = kv.key().c_str();
+    if (!secrets && isSecret(key)) {
+      continue;
+    }
+    if (!first) {
+      out.print(',');
+    }
+    first = false;
+    printJsonString(out, key);
+    out.print(':');
+    ArduinoJson6194_F1::serializeJson(kv.value(), out);
+  }
+  out.print('}');
+}
+
+bool WebServer::isSecret(const String& key) {
+  const auto type = elementType(key);
+  if (type) {
+    return *type == ElementType::PASSWORD;
+  }
+  return std::any_of(
+    m_configKeys.begin(), m_configKeys.end(), [&key](const ConfigKey& configKey) {
+      return configKey.secret && configKey.key == key;
+    });
+}
+
+void WebServer::onConfigImportBody(
+  AsyncWebServerRequest* request,
+  const uint8_t* data,
+  size_t len,
+  size_t index,
+  size_t total) {
+  // the body is staged in the temp object of the request which frees it. A body
+  // larger than the configuration is dropped chunk by chunk and answered with 413.
+  if (index == 0 && total <= m_config.capacity()) {
+    request->_tempObject = malloc(total + 1);
+  }
+
+  auto* body = static_cast<char*>(request->_tempObject);
+  if (body == nullptr || index + len > total) {
+    return;
+  }
+  memcpy(body + index, data, len);
+  if (index + len == total) {
+    body[total] = '\0';
+  }
+}
+
+void WebServer::onConfigImport(AsyncWebServerRequest* request) {
+  auto* body = static_cast<char*>(request->_tempObject);
+  if (body == nullptr) {
+    const auto length = request->contentLength();
+    if (length == 0) {
+      send(request, HTTP_BAD_REQUEST, "text/plain", "Expected a json object");
+    } else if (length > m_config.capacity()) {
+      send(
+        request,
+        HTTP_PAYLOAD_TOO_LARGE,
+        "text/plain",
+        "Import of " + String(length) + " bytes exceeds the limit of " +
+          String(m_config.capacity()) + " bytes");
+    } else {
+      send(request, HTTP_SERVICE_UNAVAILABLE, "text/plain", "Out of memory");
+    }
+    return;
+  }
+
+  // parsed in place, strings point into the body. setValues copies them, the body
+  // is freed with the request.
+  DynamicJsonDocument values(m_config.capacity());
+  const auto error = deserializeJson(values, body, request->contentLength());
+  if (error != DeserializationError::Ok || !values.is<JsonObject>()) {
+    send(request, HTTP_BAD_REQUEST, "text/plain", "Invalid json object");
+    return;
+  }
+
+  // validated completely before the first value is changed
+  for (const auto& kv : values.as<JsonObject>()) {
+    const String key = kv.key().c_str();
+    if (!importValue(key, kv.value())) {
+      m_logger.log(yal::Level::WARNING, "Rejecting import of '%'", key.c_str());
+      send(request, HTTP_BAD_REQUEST, "text/plain", "Invalid value of " + key);
+      return;
+    }
+  }
+
+  if (!m_config.setValues(values.as<JsonObjectConst>())) {
+    send(request, HTTP_PAYLOAD_TOO_LARGE, "text/plain", "Configuration is full");
+    return;
+  }
+  send(request, HTTP_OK, "text/plain", "Imported " + String(values.size()) + " values");
+}
+
+bool WebServer::importValue(const String& key, JsonVariant value) {
+  const auto type = elementType(key);
+  if (!type) {
+    const auto known = std::find_if(
+      m_configKeys.begin(), m_configKeys.end(), [&key](const ConfigKey& configKey) {
+        return configKey.key == key;
+      });
+    return known != m_configKeys.end() && known->check(value);
+  }
+
+  // exports of earlier versions have numbers as text
+  switch (*type) {
+    case ElementType::INT:
+      if (value.is<const char*>()) {
+        const auto number = parseInt(value.as<const char*>());
+        return number && value.set(*number);
+      }
+      return value.is<int32_t>();
+    case ElementType::DOUBLE:
+      if (value.is<const char*>()) {
+        const auto number = parseDouble(value.as<const char*>());
+        return number && value.set(*number);
+      }
+      return value.is<double>();
+    case ElementType::BUTTON:
+    case ElementType::UPLOAD:
+      return false;
+    default:
+      return value.is<const char*>();
+  }
+}
+
+bool WebServer::validValue(const String& key, const String& text) {
+  if (text.isEmpty()) {
+    return true;
+  }
+  const auto type = elementType(key);
+  if (type == ElementType::INT) {
+    return parseInt(text.c_str()).has_value();
+  }
+  if (type == ElementType::DOUBLE) {
+    return parseDouble(text.c_str()).has_value();
+  }
+  return true;
+}
+
+void WebServer::setTypedValue(const String& key, const String& text) {
+  const auto type = elementType(key);
+  if (type == ElementType::INT || type == ElementType::DOUBLE) {
+    // an empty number field keeps the stored value
+    if (text.isEmpty()) {
+      return;
+    }
+    if (type == ElementType::INT) {
+      m_config.setValue(key, *parseInt(text.c_str()), false);
+    } else {
+      m_config.setValue(key, *parseDouble(text.c_str()), false);
+    }
+    return;
+  }
+  m_config.setValue(key, text, false);
+}
+
 void WebServer::redirectBackToHome(
   AsyncWebServerRequest* request,
-  const std::chrono::seconds& delay) {
+  const std::chrono::seconds& delay,
+  const String& location) {
+  auto* response = request->beginResponse(HTTP_FOUND);
   if (delay > 0s) {
     m_redirectDelay = delay;
-    request->redirect(s_redirectDelayedURL);
+    response->addHeader("Location", s_redirectDelayedURL);
   } else {
-    request->redirect("/");
+    response->addHeader("Location", location);
+  }
+  send(request, HTTP_FOUND, response);
+}
+
+bool WebServer::onStaticButton(
+  FlashString configName,
+  ButtonElement::OnClick&& onClick,
+  std::chrono::seconds delayBeforeRedirect) {
+  if (!hasStaticElement(configName.toString(), ElementType::BUTTON)) {
+    m_logger.log(
+      yal::Level::ERROR, "Static ui has no button %", configName.toString().c_str());
+    return false;
+  }
+
+  m_staticElements.addButton(
+    FlashString(""), std::move(configName), std::move(onClick), delayBeforeRedirect);
+  return true;
+}
+
+bool WebServer::hasStaticElement(const String& configName, ElementType type) const {
+  for (size_t i = 0; i < m_staticUi.entryCount; ++i) {
+    ui::Entry entry{};
+    memcpy_P(&entry, m_staticUi.entries + i, sizeof(entry));
+    if (entry.type == type && staticNameEquals(entry, configName)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::optional<ElementType> WebServer::elementType(const String& configName) {
+  auto* any = findAny(configName);
+  const auto* element = any == nullptr ? nullptr : anyToElement(*any);
+  if (element != nullptr) {
+    return element->type();
+  }
+
+  for (size_t i = 0; i < m_staticUi.entryCount; ++i) {
+    ui::Entry entry{};
+    memcpy_P(&entry, m_staticUi.entries + i, sizeof(entry));
+    if (staticNameEquals(entry, configName)) {
+      return entry.type;
+    }
   }
+  return std::nullopt;
+}
+
+bool WebServer::staticNameEquals(const ui::Entry& entry, const String& name) const {
+  return entry.nameLength == name.length() &&
+    memcmp_P(name.c_str(), m_staticUi.names + entry.nameOffset, entry.nameLength) == 0;
 }
 
 bool WebServer::containerSetupDone() {
+  for (auto& any : m_staticElements.elements()) {
+    Element* element = anyToElement(any);
+    if (element != nullptr) {
+      m_elementMap.push_back({element, &any});
+    }
+  }
+
   for (auto& container : m_container) {
     for (auto& any : container.elements()) {
       Element* element = anyToElement(any);
       if (element != nullptr) {
-        m_elementMap[element->configName()] = &any;
-        m_logger.log(yal::Level::DEBUG, "Adding % to map", element->configName().c_str());
+        m_elementMap.push_back({element, &any});
       }
     }
   }
 
+  std::sort(
+    m_elementMap.begin(),
+    m_elementMap.end(),
+    [](const ElementEntry& lhs, const ElementEntry& rhs) {
+      return lhs.element->configName().compare(rhs.element->configName()) < 0;
+    });
+  m_logger.log(yal::Level::DEBUG, "Added % elements to map", m_elementMap.size());
+
+  if (m_pageStorage == PageStorage::FLASH) {
+    buildFlashPage();
+  } else if (!updateHtmlIndex()) {
+    return false;
+  }
+
+  registerUploadRoutes();
+  return true;
+}
+
+bool WebServer::updateHtmlIndex() {
+  HeapProfiler::Scope profile("html_check");
+  ++m_indexVersion;
   const auto checkResult = checkAndWriteHTML(false);
   if (checkResult == WriteAndCheckResult::SUCCESS) {
     return true;
@@ -114,10 +722,56 @@ bool WebServer::containerSetupDone() {
 
   m_logger.log(yal::Level::INFO, "MD5 mismatch, writing html index file");
   const auto writeResult = checkAndWriteHTML(true);
+
+  // earlier versions stored the complete page
+  Configuration::FileSystemHandle fileSystem;
+  if (fileSystem.begin() && LittleFS.exists(s_legacyHtmlIndex)) {
+    LittleFS.remove(s_legacyHtmlIndex);
+  }
   return writeResult == WriteAndCheckResult::SUCCESS;
 }
 
+bool WebServer::reloadFileSystem() {
+  m_logger.log(yal::Level::INFO, "Reloading configuration and html index");
+  m_config.reload();
+  // the page of PageStorage::FLASH does not use the file system
+  return m_pageStorage == PageStorage::FLASH || updateHtmlIndex();
+}
+
+void WebServer::buildFlashPage() {
+  HeapProfiler::Scope profile("flash_page");
+  ++m_indexVersion;
+  m_panelRanges.clear();
+
+  // runtime containers are only known at runtime, they are rendered once to ram
+  std::stringstream ss;
+  for (auto& container : m_container) {
+    const auto offset = static_cast<size_t>(ss.tellp());
+    makeContainer(container, ss);
+    m_panelRanges.push_back({offset, static_cast<size_t>(ss.tellp()) - offset});
+  }
+  m_runtimeHtml = ss.str();
+
+  // added in the order of FlashRegion
+  m_flashPage.addRegion(
+    reinterpret_cast<PGM_P>(assets::s_indexStart), assets::s_indexStartLength);
+  m_flashPage.addRegion(m_staticUi.html, m_staticUi.htmlLength);
+  m_flashPage.addRegion(m_runtimeHtml.data(), m_runtimeHtml.size());
+  m_flashPage.addRegion(s_panelFieldHtml, sizeof(s_panelFieldHtml) - 1);
+  m_flashPage.addRegion(
+    reinterpret_cast<PGM_P>(assets::s_indexEnd), assets::s_indexEndLength);
+  m_logger.log(
+    yal::Level::DEBUG, "Page served from flash, % bytes in ram", m_runtimeHtml.size());
+}
+
 WebServer::WriteAndCheckResult WebServer::checkAndWriteHTML(bool writeFS) {
+  m_panelRanges.clear();
+
+  // start and end of the page and the static ui are read from flash
+  if (m_container.empty()) {
+    return WriteAndCheckResult::SUCCESS;
+  }
+
   unsigned int offset = 0U;
 
   const auto checkOrWrite = [&](
@@ -142,95 +796,24 @@ WebServer::WriteAndCheckResult WebServer::checkAndWriteHTML(bool writeFS) {
     return WriteAndCheckResult::SUCCESS;
   };
 
-  {
-    const auto startLen = std::strlen(s_htmlIndexStart);
-    const auto result = checkOrWrite(
-      offset, reinterpret_cast<const uint8_t*>(s_htmlIndexStart), startLen, true);
-    if (result != WriteAndCheckResult::SUCCESS) {
-      return result;
-    }
-
-    offset += startLen;
-  }
-
   for (auto& container : m_container) {
     std::stringstream ss;
-    static const constexpr auto containerStart PROGMEM =
-      R"(<div class="flex-card"><div class="hero">)";
-    ss << containerStart;
-
-    static const constexpr auto h3 PROGMEM = "<h3>";
-    ss << h3;
-
-    ss << container.title().c_str();
-
-    static const constexpr auto containerClass PROGMEM =
-      R"(</h3></div><div class="content">)";
-
-    ss << containerClass;
-
-    for (auto& any : container.elements()) {
-      auto* element = anyToElement(any);
-      if (nullptr == element) {
-        m_logger.log(yal::Level::FATAL, "failed to cast any to element!");
-        continue;
-      }
-
-      String elementValue = "%" + element->configName() + "%";
-      String text;
-
-      switch (element->type()) {
-        case ElementType::BUTTON:
-          makeButton(element, ss);
-          break;
-        case ElementType::LIST:
-          makeDatalist(element, elementValue, "text", ss);
-          break;
-        case ElementType::DROPDOWN:
-          makeSelect(element, elementValue, "text", ss);
-          break;
-        case ElementType::STRING:
-          makeInput(element, elementValue, "text", ss);
-          break;
-        case ElementType::PASSWORD:
-          makeInput(element, elementValue, "password", ss);
-          break;
-        case ElementType::INT:
-        case ElementType::DOUBLE:
-          makeInput(element, elementValue, "number", ss);
-          break;
-        case ElementType::UPLOAD:
-          makeUpload(element, ss);
-          break;
-      }
-    }
-
-    static const auto containerEnd PROGMEM = "</div></div>";
-    ss << containerEnd;
+    makeContainer(container, ss);
 
     ss.seekg(0, std::ios::end);
     const auto ssSize = ss.tellg();
     ss.seekg(0, std::ios::beg);
 
-    const auto result =
-      checkOrWrite(offset, reinterpret_cast<const uint8_t*>(ss.str().data()), ssSize);
+    const auto result = checkOrWrite(
+      offset, reinterpret_cast<const uint8_t*>(ss.str().data()), ssSize, offset == 0);
     if (result != WriteAndCheckResult::SUCCESS) {
       return result;
     }
 
+    m_panelRanges.push_back({offset, static_cast<size_t>(ssSize)});
     offset += ssSize;
   }
 
-  {
-    const auto endLen = std::strlen(s_htmlIndexEnd);
-    const auto result =
-      checkOrWrite(offset, reinterpret_cast<const uint8_t*>(s_htmlIndexEnd), endLen);
-    if (result != WriteAndCheckResult::SUCCESS) {
-      return result;
-    }
-    offset += endLen;
-  }
-
   if (!writeFS) {
     Configuration::FileHandle file(m_htmlIndex.c_str());
     file.open("r");
@@ -243,15 +826,70 @@ WebServer::WriteAndCheckResult WebServer::checkAndWriteHTML(bool writeFS) {
   return WriteAndCheckResult::SUCCESS;
 }
 
+void WebServer::makeContainer(Container& container, std::stringstream& ss) {
+  static const constexpr auto containerStart PROGMEM =
+    R"(<div class="flex-card"><div class="hero">)";
+  ss << containerStart;
+
+  static const constexpr auto h3 PROGMEM = "<h3>";
+  ss << h3;
+
+  ss << container.title();
+
+  static const constexpr auto containerClass PROGMEM =
+    R"(</h3></div><div class="content">)";
+
+  ss << containerClass;
+
+  for (auto& any : container.elements()) {
+    auto* element = anyToElement(any);
+    if (nullptr == element) {
+      m_logger.log(yal::Level::FATAL, "failed to cast any to element!");
+      continue;
+    }
+
+    String elementValue = "%" + element->configName().toString() + "%";
+    String text;
+
+    switch (element->type()) {
+      case ElementType::BUTTON:
+        makeButton(element, ss);
+        break;
+      case ElementType::LIST:
+        makeDatalist(element, elementValue, "text", ss);
+        break;
+      case ElementType::DROPDOWN:
+        makeSelect(element, elementValue, "text", ss);
+        break;
+      case ElementType::STRING:
+        makeInput(element, elementValue, "text", ss);
+        break;
+      case ElementType::PASSWORD:
+        makeInput(element, elementValue, "password", ss);
+        break;
+      case ElementType::INT:
+      case ElementType::DOUBLE:
+        makeInput(element, elementValue, "number", ss);
+        break;
+      case ElementType::UPLOAD:
+        makeUpload(element, ss);
+        break;
+    }
+  }
+
+  static const auto containerEnd PROGMEM = "</div></div>";
+  ss << containerEnd;
+}
+
 void WebServer::makeInput(
   const Element* element,
   const String& elementValue,
   const String& inputType,
   std::stringstream& ss) {
-  const auto& id = element->configName().c_str();
+  const auto& id = element->configName();
   // clang-format off
   ss <<
-    "<label for=\"" << id << "\">" << element->label().c_str() << "</label>"
+    "<label for=\"" << id << "\">" << element->label() << "</label>"
     "<input id=\"" << id
       << R"(" class="inputLarge")"
       << "name=\"" << id << "\" "
@@ -268,21 +906,30 @@ void WebServer::makeDatalist(
   const String& elementValue,
   const String& inputType,
   std::stringstream& ss) {
-  const auto& id = element->configName().c_str();
-  const auto listId = (id + m_optionSuffix);
+  const auto& id = element->configName();
+  const auto listId = id.toString() + m_optionSuffix;
+  const auto onDemand =
+    static_cast<const ChoiceElementBase*>(element)->loading() == OptionLoading::ON_DEMAND;
   // clang-format off
   ss <<
-    "<label for=\"" << id << "\">" << element->label().c_str() << "</label>"
+    "<label for=\"" << id << "\">" << element->label() << "</label>"
     "<input id=\"" << id
       << R"(" class="inputLarge")"
       << "name=\"" << id << "\" "
       << "value=\"" << elementValue.c_str() << "\" "
       << "type=\"" << inputType.c_str() << "\" "
-      << "list=\"" << listId.c_str() << "\" "
+      << "list=\"" << listId.c_str() << "\" ";
+  if (onDemand) {
+    ss << "data-options=\"" << id << "\" ";
+  }
+  ss
       << "form=\"formUpdateConfig\" "
       << "/>"
-    << "<datalist id=\"" << listId.c_str() << "\">"
-    << "%" << listId.c_str() << "%"
+    << "<datalist id=\"" << listId.c_str() << "\">";
+  if (!onDemand) {
+    ss << "%" << listId.c_str() << "%";
+  }
+  ss
     << "</datalist>"
     << "<br/>";
   // clang-format on
@@ -293,31 +940,43 @@ void WebServer::makeSelect(
   const String& elementValue,
   const String& inputType,
   std::stringstream& ss) {
-  const auto& id = element->configName().c_str();
-  const auto optionId = (id + m_optionSuffix);
+  const auto& id = element->configName();
+  const auto optionId = id.toString() + m_optionSuffix;
+  const auto onDemand =
+    static_cast<const ChoiceElementBase*>(element)->loading() == OptionLoading::ON_DEMAND;
   // clang-format off
     ss <<
-       "<label for=\"" << id << "\">" << element->label().c_str() << "</label>"
+       "<label for=\"" << id << "\">" << element->label() << "</label>"
        "<select id=\"" << id
        << R"(" class="otherLarge")"
        << "name=\"" << id << "\" "
-       << "type=\"" << inputType.c_str() << "\" "
-       << "form=\"formUpdateConfig\" >"
-       << "%" << optionId.c_str() << "%"
+       << "type=\"" << inputType.c_str() << "\" ";
+    if (onDemand) {
+      // only the selected option, the others are loaded when the select gets the focus
+      ss << "data-options=\"" << id << "\" "
+         << "form=\"formUpdateConfig\" >"
+         << "<option value=\"" << elementValue.c_str() << "\" selected>"
+         << elementValue.c_str()
+         << "</option>";
+    } else {
+      ss << "form=\"formUpdateConfig\" >"
+         << "%" << optionId.c_str() << "%";
+    }
+    ss
        << "</select>"
        << "<br/>";
   // clang-format on
 }
 
 void WebServer::makeButton(const Element* element, std::stringstream& ss) {
-  const auto& id = element->configName().c_str();
+  const auto& id = element->configName();
   // clang-format off
   ss <<
     "<label for=\"" << id << "\"></label>"
     "<input id=\"" << id
       << R"(" class="btn btnFlexContainer otherLarge")"
       << "name=\"" << id << "\" "
-      << "value=\"" << element->label().c_str() << "\" "
+      << "value=\"" << element->label() << "\" "
       << "form=\"formOnClick\" "
       << "type=\"submit\" "
       << "/>"
@@ -326,41 +985,26 @@ void WebServer::makeButton(const Element* element, std::stringstream& ss) {
 }
 
 void WebServer::makeUpload(const Element* element, std::stringstream& ss) {
-  const auto& id = element->configName().c_str();
-  const auto& idStr = element->configName();
-  const auto& formId = element->configName() + "__form";
-  const auto& browseId = (element->configName() + "__browse").c_str();
+  const auto& id = element->configName();
+  const auto idStr = id.toString();
+  const auto browseId = idStr + "__browse";
   const auto* upload = findElement<UploadElement>(idStr);
   const auto url = "/" + idStr + "__upload";
 
-  m_asyncWebServer.on(url.c_str(), HTTP_GET, [](AsyncWebServerRequest* request) {
-    request->send(HTTP_DENIED, CONTENT_TYPE_HTML, "403 Access denied");
-  });
-
-  m_asyncWebServer.on(
-    url.c_str(),
-    HTTP_POST,
-    [upload](AsyncWebServerRequest* request) { upload->onPost(request); },
-    [upload](
-      AsyncWebServerRequest* request,
-      const String& filename,
-      size_t index,
-      uint8_t* data,
-      size_t len,
-      bool final) { upload->onUpload(request, filename, index, data, len, final); });
   // clang-format off
   ss << "<form method='POST' action='"<< url.c_str()
      << "' enctype='multipart/form-data'>"
-      << "<label for=\"" << browseId << "\">"
-        << upload->browseLabel().c_str()
+      << "<label for=\"" << browseId.c_str() << "\">"
+        << upload->browseLabel()
       << "</label>"
-      << "<input type='file' class=\"input inputLarge\" accept='.bin,.bin.gz' "
-        << "id=\"" << browseId << "\" "
-        << "name=\"" << browseId << "\">"
+      << "<input type='file' class=\"input inputLarge\" "
+        << "accept='" << upload->acceptedFiles() << "' "
+        << "id=\"" << browseId.c_str() << "\" "
+        << "name=\"" << browseId.c_str() << "\">"
       << "<label for=\"" << id << "\"></label>"
       << "<br/>"
       // dummy label to indent button
-      << "<label for=\"" << browseId << "\">"
+      << "<label for=\"" << browseId.c_str() << "\">"
       << "</label>"
       << "<input type='submit' value='Upload' class=\"btn btnFlexContainer\""
         << "id=\"" << id << "\">"
@@ -370,6 +1014,70 @@ void WebServer::makeUpload(const Element* element, std::stringstream& ss) {
   // clang-format on
 }
 
+void WebServer::registerUploadRoutes() {
+  using RouteClass = AdmissionControl::RouteClass;
+  for (auto& container : m_container) {
+    for (auto& any : container.elements()) {
+      const auto* element = anyToElement(any);
+      if (element == nullptr || element->type() != ElementType::UPLOAD) {
+        continue;
+      }
+
+      const auto configName = element->configName().toString();
+      const auto* upload = findElement<UploadElement>(configName);
+      const auto url = "/" + configName + "__upload";
+
+      m_asyncWebServer.on(
+        url.c_str(),
+        HTTP_GET,
+        instrument(
+          HTTP_GET, url, RouteClass::PROBE, [this](AsyncWebServerRequest* request) {
+            send(request, HTTP_DENIED, CONTENT_TYPE_HTML, "403 Access denied");
+          }));
+
+      const auto route = m_metrics.addRoute(routeName(HTTP_POST, url));
+      m_asyncWebServer.on(
+        url.c_str(),
+        HTTP_POST,
+        instrument(
+          HTTP_POST,
+          url,
+          RouteClass::UPLOAD,
+          [this, upload, route](AsyncWebServerRequest* request) {
+            if (m_admission.uploadRejected(request)) {
+              reject(request, route, "upload rejected");
+              return;
+            }
+            upload->onPost(request);
+          }),
+        [this, upload, route](
+          AsyncWebServerRequest* request,
+          const String& filename,
+          size_t index,
+          uint8_t* data,
+          size_t len,
+          bool final) {
+          const auto* reason = m_admission.admitUpload(request, index, final);
+          if (reason == nullptr) {
+            upload->onUpload(request, filename, index, data, len, final);
+            return;
+          }
+
+          if (index == 0) {
+            m_logger.log(
+              yal::Level::WARNING,
+              "Rejecting upload of %: %",
+              m_metrics.routeName(route),
+              reason);
+            m_metrics.rejected(route);
+            // stops the transfer, the handler answers with 503 if the body was complete
+            request->client()->close();
+          }
+        });
+    }
+  }
+}
+
 bool WebServer::fileSystemAndDataChunksEqual(
   unsigned int offset,
   const uint8_t* data,
@@ -450,23 +1158,336 @@ void WebServer::reset(AsyncWebServerRequest* request, const char* reason) {
     EspClass::reset();
   });
 
-  request->send(response);
+  send(request, HTTP_OK, response);
 }
 
 void WebServer::rootHandleGet(AsyncWebServerRequest* const request) {
   logMemory(m_logger);
   m_logger.log(yal::Level::DEBUG, "Received request for /");
 
-  LittleFS.begin();
-  request->send(
-    LittleFS,
-    m_htmlIndex,
+  if (m_pageStorage == PageStorage::FILE_SYSTEM && Configuration::fileSystemLocked()) {
+    send(request, HTTP_SERVICE_UNAVAILABLE, CONTENT_TYPE_HTML, "Updating file system");
+    return;
+  }
+
+  const auto version = pageVersion();
+  const auto etag = pageETag(version);
+  if (notModified(request, etag)) {
+    return;
+  }
+
+  AsyncWebServerResponse* response = nullptr;
+  if (m_pageStorage == PageStorage::FLASH) {
+    response = pageResponse(request, s_allPanels);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    send(request, HTTP_OK, response);
+    return;
+  }
+
+  if (!(m_cachedPage == version)) {
+    m_pageCacheValid = false;
+  }
+  // a page response still reads the cache file, it must not be rewritten
+  if (!m_pageCacheValid && pageCacheWritable() && m_metrics.inFlight(m_rootRoute) == 0) {
+    m_pageCacheValid = renderPageCache();
+    m_pageCacheMillis = millis();
+    m_cachedPage = version;
+  }
+
+  if (m_pageCacheValid) {
+    // the source keeps the file system mounted until the response is deleted
+    auto cache = std::make_shared<PageSource>();
+    cache->addFile(m_htmlCache.c_str());
+    response = request->beginChunkedResponse(
+      CONTENT_TYPE_HTML, [cache](uint8_t* buffer, size_t maxLen, size_t index) {
+        return cache->read(buffer, maxLen);
+      });
+  } else {
+    response = pageResponse(request, s_allPanels);
+  }
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  send(request, HTTP_OK, response);
+}
+
+void WebServer::onPanel(AsyncWebServerRequest* const request) {
+  const auto id = request->hasParam("id") ? request->getParam("id")->value().toInt() : -1;
+  if (id < 0 || static_cast<size_t>(id) >= panelCount()) {
+    onNotFound(request);
+    return;
+  }
+
+  if (m_pageStorage == PageStorage::FILE_SYSTEM && Configuration::fileSystemLocked()) {
+    send(request, HTTP_SERVICE_UNAVAILABLE, CONTENT_TYPE_HTML, "Updating file system");
+    return;
+  }
+
+  const auto panel = static_cast<size_t>(id);
+  const auto etag = pageETag(pageVersion(), panel);
+  if (notModified(request, etag)) {
+    return;
+  }
+
+  auto* response = pageResponse(request, panel);
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  send(request, HTTP_OK, response);
+}
+
+AsyncWebServerResponse* WebServer::pageResponse(
+  AsyncWebServerRequest* request,
+  size_t panel) {
+  if (m_pageStorage == PageStorage::FLASH) {
+    // no template processor, the reader resolves the placeholders itself
+    auto reader = std::make_shared<FlashPage::Reader>(flashPageReader(panel));
+    return request->beginChunkedResponse(
+      CONTENT_TYPE_HTML, [reader](uint8_t* buffer, size_t maxLen, size_t index) {
+        return reader->read(buffer, maxLen);
+      });
+  }
+
+  auto source = std::make_shared<PageSource>(pageSource(panel));
+  return request->beginChunkedResponse(
     CONTENT_TYPE_HTML,
-    false,
-    std::bind(&WebServer::templateCallback, this, std::placeholders::_1));
+    [source](uint8_t* buffer, size_t maxLen, size_t index) {
+      return source->read(buffer, maxLen);
+    },
+    [this, panel](const String& templateString) {
+      if (templateString == s_panelField) {
+        return String(panel);
+      }
+      return templateCallback(templateString);
+    });
+}
+
+String WebServer::pageETag(const PageVersion& version, size_t panel) const {
+  std::array<char, 64> etag{};
+  snprintf(
+    etag.data(),
+    etag.size(),
+    "\"%08x-%u-%u-%u-%d\"",
+    static_cast<unsigned>(m_bootId),
+    static_cast<unsigned>(version.config),
+    static_cast<unsigned>(version.options),
+    static_cast<unsigned>(version.index),
+    panel == s_allPanels ? -1 : static_cast<int>(panel));
+  return etag.data();
+}
+
+PageSource WebServer::pageSource(size_t panel) const {
+  PageSource source;
+  source.addFlash(
+    reinterpret_cast<PGM_P>(assets::s_indexStart), assets::s_indexStartLength);
+
+  if (panel == s_allPanels) {
+    source.addFlash(m_staticUi.html, m_staticUi.htmlLength);
+    if (!m_container.empty()) {
+      source.addFile(m_htmlIndex.c_str());
+    }
+  } else if (panel < m_staticUi.panelCount) {
+    ui::Panel staticPanel{};
+    memcpy_P(&staticPanel, m_staticUi.panels + panel, sizeof(staticPanel));
+    source.addFlash(m_staticUi.html + staticPanel.htmlOffset, staticPanel.htmlLength);
+  } else {
+    const auto& range = m_panelRanges.at(panel - m_staticUi.panelCount);
+    source.addFile(m_htmlIndex.c_str(), range.offset, range.length);
+  }
+
+  if (panel != s_allPanels) {
+    source.addFlash(s_panelFieldHtml, sizeof(s_panelFieldHtml) - 1);
+  }
+  source.addFlash(reinterpret_cast<PGM_P>(assets::s_indexEnd), assets::s_indexEndLength);
+  return source;
+}
+
+FlashPage::Reader WebServer::flashPageReader(size_t panel) {
+  FlashPage::Reader reader(m_flashPage, [this, panel](const String& templateString) {
+    if (templateString == s_panelField) {
+      return String(panel);
+    }
+    return templateCallback(templateString);
+  });
+
+  const auto whole = [this](FlashRegion region) {
+    return FlashPage::Part{region, 0, m_flashPage.regionLength(region)};
+  };
+
+  reader.add(whole(REGION_START));
+  if (panel == s_allPanels) {
+    reader.add(whole(REGION_STATIC_UI));
+    reader.add(whole(REGION_RUNTIME));
+  } else if (panel < m_staticUi.panelCount) {
+    ui::Panel staticPanel{};
+    memcpy_P(&staticPanel, m_staticUi.panels + panel, sizeof(staticPanel));
+    reader.add({REGION_STATIC_UI, staticPanel.htmlOffset, staticPanel.htmlLength});
+  } else {
+    const auto& range = m_panelRanges.at(panel - m_staticUi.panelCount);
+    reader.add({REGION_RUNTIME, range.offset, range.length});
+  }
+
+  if (panel != s_allPanels) {
+    reader.add(whole(REGION_PANEL_FIELD));
+  }
+  reader.add(whole(REGION_END));
+  return reader;
+}
+
+String WebServer::panelUrl(size_t panel) {
+  return "/panel?id=" + String(panel);
+}
+
+bool WebServer::panelHasElement(size_t panel, const String& configName) {
+  if (panel < m_staticUi.panelCount) {
+    for (size_t i = 0; i < m_staticUi.entryCount; ++i) {
+      ui::Entry entry{};
+      memcpy_P(&entry, m_staticUi.entries + i, sizeof(entry));
+      if (entry.panel == panel && staticNameEquals(entry, configName)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  auto& container = m_container.at(panel - m_staticUi.panelCount);
+  return std::any_of(
+    container.elements().begin(),
+    container.elements().end(),
+    [this, &configName](std::any& any) {
+      const auto* element = anyToElement(any);
+      return element != nullptr && element->configName() == configName;
+    });
+}
+
+String WebServer::panelNavigation() const {
+  String navigation;
+  const auto count = panelCount();
+  if (count < 2) {
+    return navigation;
+  }
+
+  for (size_t panel = 0; panel < count; ++panel) {
+    navigation += "<a href=\"";
+    navigation += panelUrl(panel);
+    navigation += "\">";
+    if (panel < m_staticUi.panelCount) {
+      ui::Panel staticPanel{};
+      memcpy_P(&staticPanel, m_staticUi.panels + panel, sizeof(staticPanel));
+      std::array<char, UINT8_MAX + 1> title{};
+      memcpy_P(
+        title.data(), m_staticUi.html + staticPanel.titleOffset, staticPanel.titleLength);
+      navigation += title.data();
+    } else {
+      m_container[panel - m_staticUi.panelCount].title().appendTo(navigation);
+    }
+    navigation += "</a>";
+  }
+  return navigation;
+}
+
+bool WebServer::pageCacheWritable() const {
+  const auto interval = static_cast<unsigned long>(m_pageCacheInterval.count());
+  if (m_pageCacheInterval.count() <= 0) {
+    return false;
+  }
+  return !m_pageCacheMillis || millis() - *m_pageCacheMillis >= interval;
+}
+
+bool WebServer::renderPageCache() {
+  HeapProfiler::Scope profile("page_cache");
+  Configuration::FileSystemHandle fileSystem;
+  if (!fileSystem.begin()) {
+    return false;
+  }
+
+  auto source = pageSource();
+  Configuration::FileHandle cache(m_htmlCache.c_str(), false);
+  if (!cache.open("w")) {
+    m_logger.log(yal::Level::ERROR, "Failed to open the page cache");
+    return false;
+  }
+
+  // same rules as the template processor of the web server: %name% is replaced,
+  // %% is a single % and names longer than 32 characters are kept as they are
+  static constexpr size_t maxNameLength = 32;
+  std::array<uint8_t, 256> input{};
+  std::array<uint8_t, 256> output{};
+  std::array<char, maxNameLength + 1> name{};
+  size_t outputLength = 0;
+  size_t nameLength = 0;
+  bool inPlaceholder = false;
+  bool success = true;
+
+  const auto write = [&](const char* data, size_t len) {
+    while (len > 0 && success) {
+      if (outputLength == output.size()) {
+        success = cache.file().write(output.data(), outputLength) == outputLength;
+        outputLength = 0;
+      }
+      const auto chunk = std::min(len, output.size() - outputLength);
+      memcpy(output.data() + outputLength, data, chunk);
+      outputLength += chunk;
+      data += chunk;
+      len -= chunk;
+    }
+  };
+
+  size_t readSize = 0;
+  while ((readSize = source.read(input.data(), input.size())) > 0) {
+    for (size_t i = 0; i < readSize; ++i) {
+      const auto c = static_cast<char>(input[i]);
+      if (!inPlaceholder) {
+        if (c == '%') {
+          inPlaceholder = true;
+          nameLength = 0;
+        } else {
+          write(&c, 1);
+        }
+        continue;
+      }
+
+      if (c == '%') {
+        inPlaceholder = false;
+        if (nameLength == 0) {
+          write("%", 1);
+          continue;
+        }
+        name[nameLength] = '\0';
+        const auto value = templateCallback(name.data());
+        write(value.c_str(), value.length());
+      } else if (nameLength == maxNameLength) {
+        inPlaceholder = false;
+        write("%", 1);
+        write(name.data(), nameLength);
+        write(&c, 1);
+      } else {
+        name[nameLength++] = c;
+      }
+    }
+  }
+
+  if (inPlaceholder) {
+    write("%", 1);
+    write(name.data(), nameLength);
+  }
+  if (success && outputLength > 0) {
+    success = cache.file().write(output.data(), outputLength) == outputLength;
+  }
+
+  if (!success) {
+    m_logger.log(yal::Level::ERROR, "Failed to write the page cache");
+    return false;
+  }
+  m_logger.log(yal::Level::DEBUG, "Rendered page cache, % bytes", cache.file().size());
+  return true;
 }
 
 String WebServer::templateCallback(const String& templateString) {
+  HeapProfiler::Scope profile("template_render");
+  if (templateString == s_panelNavTemplate) {
+    return panelNavigation();
+  }
+
   String templ = templateString;
   bool getDataList = false;
   if (templ.endsWith(m_optionSuffix)) {
@@ -481,13 +1502,13 @@ String WebServer::templateCallback(const String& templateString) {
   } else if (dropdownValue != nullptr) {
     return optionTemplate(templ, dropdownValue, getDataList);
   } else {
-    const auto value = m_config.value<String>(templ);
+    const auto value = m_config.text(templ);
     m_logger.log(
       yal::Level::DEBUG,
       "Replacing template string '%' with %",
       templ.c_str(),
       value.c_str());
-    return m_config.value<String>(templ);
+    return value;
   }
 }
 
@@ -500,38 +1521,76 @@ String WebServer::optionTemplate(
   }
 
   String value;
-  const auto selected = m_config.value<String>(listValue->configName());
+  const auto selected = m_config.value<String>(listValue->configName().toString());
   const auto& options = listValue->options();
   m_logger.log(yal::Level::DEBUG, "List has % options", options.size());
 
   for (const auto& option : options) {
-    m_logger.log(yal::Level::DEBUG, "Adding select option %", option.c_str());
-    String selectedStr;
-    if (option == selected) {
-      selectedStr = "selected";
-    }
-    value +=
-      "<option value=\"" + option + "\" " + selectedStr + ">" + option + "</option>";
+    value += "<option value=\"";
+    option.appendTo(value);
+    value += option == selected ? "\" selected>" : "\" >";
+    option.appendTo(value);
+    value += "</option>";
   }
   return value;
 }
 
 void WebServer::rootHandlePost(AsyncWebServerRequest* const request) {
   m_logger.log(yal::Level::INFO, "Received POST on /");
+
+  // the form of a panel page only changes the elements of its container
+  auto panel = s_allPanels;
+  if (request->hasParam(s_panelField, true)) {
+    const auto id = request->getParam(s_panelField, true)->value().toInt();
+    if (id < 0 || static_cast<size_t>(id) >= panelCount()) {
+      send(request, HTTP_BAD_REQUEST, "text/plain", "Unknown panel");
+      return;
+    }
+    panel = static_cast<size_t>(id);
+  }
+
+  std::vector<const AsyncWebParameter*> params;
   for (size_t i = 0; i < request->params(); ++i) {
     const auto param = request->getParam(i);
+    if (param->name() == s_panelField) {
+      continue;
+    }
+    if (panel != s_allPanels && !panelHasElement(panel, param->name())) {
+      m_logger.log(
+        yal::Level::DEBUG,
+        "Ignoring param '%' outside of panel %",
+        param->name().c_str(),
+        panel);
+      continue;
+    }
+    params.push_back(param);
+  }
+
+  // all values are parsed before the first one is changed
+  for (const auto* param : params) {
+    if (!validValue(param->name(), param->value())) {
+      m_logger.log(
+        yal::Level::WARNING,
+        "Rejecting value '%' of param '%'",
+        param->value().c_str(),
+        param->name().c_str());
+      send(request, HTTP_BAD_REQUEST, "text/plain", "Invalid value of " + param->name());
+      return;
+    }
+  }
+
+  for (const auto* param : params) {
     m_logger.log(
       yal::Level::DEBUG,
       "Updating param '%' to value '%'",
       param->name().c_str(),
       param->value().c_str());
-
-    m_config.setValue(param->name(), param->value(), false);
+    setTypedValue(param->name(), param->value());
   }
 
   m_config.store();
 
-  redirectBackToHome(request, 0s);
+  redirectBackToHome(request, 0s, panel == s_allPanels ? String("/") : panelUrl(panel));
 }
 
 void WebServer::eraseConfig(AsyncWebServerRequest* const request) {
@@ -576,7 +1635,7 @@ bool WebServer::isCaptivePortal(AsyncWebServerRequest* request) {
 
   AsyncWebServerResponse* response = request->beginResponse(HTTP_FOUND, "text/plain", "");
   response->addHeader("Location", "http://" + WiFi.softAPIP().toString());
-  request->send(response);
+  send(request, HTTP_FOUND, response);
   m_logger.log(yal::Level::TRACE, "Redirect for config portal");
   return true;
 }
@@ -586,7 +1645,8 @@ void WebServer::onNotFound(AsyncWebServerRequest* request) {
     return;
   }
 
-  request->send(
+  send(
+    request,
     HTTP_NOT_FOUND,
     CONTENT_TYPE_HTML,
     "<!DOCTYPE html><html><head><title>404</title></head><body><h1>404</h1></body>");
@@ -602,6 +1662,20 @@ bool WebServer::isIp(const String& str) {
   //  return std::regex_match(str.c_str(), expr);
 }
 
+std::any* WebServer::findAny(const String& key) {
+  const auto iter = std::lower_bound(
+    m_elementMap.begin(),
+    m_elementMap.end(),
+    key,
+    [](const ElementEntry& entry, const String& name) {
+      return entry.element->configName().compare(name.c_str()) < 0;
+    });
+  if (iter == m_elementMap.end() || iter->element->configName() != key) {
+    return nullptr;
+  }
+  return iter->any;
+}
+
 Element* WebServer::anyToElement(std::any& any) {
   if (std::type_index(typeid(Element)) == any.type()) {
     return std::any_cast<Element>(&any);
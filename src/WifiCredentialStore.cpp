@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/WifiCredentialStore.hpp>
+#include <algorithm>
+
+namespace esp_gui {
+
+namespace {
+// rssi used for networks which were not seen in the last scan
+constexpr int32_t s_unseenRssi = -100;
+constexpr int32_t s_failurePenalty = 10;
+constexpr int32_t s_mostRecentBonus = 5;
+}  // namespace
+
+void WifiCredentialStore::load() {
+  m_count = 0;
+  m_successSequence = 0;
+  for (const auto& network : m_config.array(m_cfgNetworks)) {
+    if (m_count >= s_maxNetworks) {
+      break;
+    }
+
+    auto& credential = m_networks[m_count];
+    credential.ssid = network[s_keySsid].as<const char*>();
+    credential.password = network[s_keyPassword].as<const char*>();
+    credential.lastSuccess = network[s_keyLastSuccess] | 0U;
+    credential.failures = network[s_keyFailures] | 0U;
+    if (credential.ssid.isEmpty()) {
+      continue;
+    }
+
+    m_successSequence = std::max(m_successSequence, credential.lastSuccess);
+    ++m_count;
+  }
+
+  m_dirty = false;
+  m_logger.log(yal::Level::DEBUG, "Loaded % stored networks", m_count);
+}
+
+bool WifiCredentialStore::validNetworks(JsonVariantConst networks) {
+  if (!networks.is<JsonArrayConst>() || networks.size() > s_maxNetworks) {
+    return false;
+  }
+
+  const auto optionalNumber = [](JsonVariantConst value) {
+    return value.isNull() || value.is<uint32_t>();
+  };
+  for (const auto& network : networks.as<JsonArrayConst>()) {
+    if (
+      !network[s_keySsid].is<const char*>() ||
+      !network[s_keyPassword].is<const char*>() ||
+      !optionalNumber(network[s_keyLastSuccess]) ||
+      !optionalNumber(network[s_keyFailures])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void WifiCredentialStore::save() {
+  if (!m_dirty) {
+    return;
+  }
+
+  auto networks = m_config.createArray(m_cfgNetworks);
+  for (size_t i = 0; i < m_count; ++i) {
+    const auto& credential = m_networks[i];
+    auto network = networks.createNestedObject();
+    network[s_keySsid] = credential.ssid;
+    network[s_keyPassword] = credential.password;
+    network[s_keyLastSuccess] = credential.lastSuccess;
+    network[s_keyFailures] = credential.failures;
+  }
+
+  m_config.store();
+  m_dirty = false;
+}
+
+void WifiCredentialStore::add(const String& ssid, const String& password) {
+  if (ssid.isEmpty()) {
+    return;
+  }
+
+  auto index = find(ssid);
+  if (index < m_count) {
+    if (m_networks[index].password != password) {
+      m_networks[index].password = password;
+      m_networks[index].failures = 0;
+      m_dirty = true;
+    }
+    return;
+  }
+
+  if (m_count < s_maxNetworks) {
+    index = m_count++;
+  } else {
+    // evict the network with the most failures, prefer the one used longest ago
+    index = 0;
+    for (size_t i = 1; i < m_count; ++i) {
+      const auto& current = m_networks[i];
+      const auto& evict = m_networks[index];
+      if (
+        current.failures > evict.failures ||
+        (current.failures == evict.failures && current.lastSuccess < evict.lastSuccess)) {
+        index = i;
+      }
+    }
+    m_logger.log(
+      yal::Level::INFO, "Store full, forgetting '%'", m_networks[index].ssid.c_str());
+  }
+
+  m_networks[index] = Credential{ssid, password, 0, 0};
+  m_dirty = true;
+  m_logger.log(yal::Level::DEBUG, "Added network '%'", ssid.c_str());
+}
+
+void WifiCredentialStore::markSuccess(size_t index) {
+  auto& credential = m_networks[index];
+  if (credential.failures != 0) {
+    credential.failures = 0;
+    m_dirty = true;
+  }
+
+  // only bump the sequence if the network changed, avoids a flash write per boot
+  if (mostRecent() != index) {
+    credential.lastSuccess = ++m_successSequence;
+    m_dirty = true;
+  }
+}
+
+void WifiCredentialStore::markFailure(size_t index) {
+  auto& credential = m_networks[index];
+  if (credential.failures < UINT8_MAX) {
+    ++credential.failures;
+    m_dirty = true;
+  }
+}
+
+size_t WifiCredentialStore::rank(const WifiScanner& scanner, Candidates& out) const {
+  for (size_t i = 0; i < m_count; ++i) {
+    auto& candidate = out[i];
+    candidate.index = i;
+    candidate.network = scanner.find(m_networks[i].ssid);
+    candidate.score = score(
+      m_networks[i],
+      candidate.network == nullptr ? s_unseenRssi : candidate.network->rssi);
+  }
+
+  std::sort(out.begin(), out.begin() + m_count, [](const auto& lhs, const auto& rhs) {
+    return lhs.score > rhs.score;
+  });
+  return m_count;
+}
+
+size_t WifiCredentialStore::mostRecent() const {
+  size_t result = m_count;
+  uint32_t sequence = 0;
+  for (size_t i = 0; i < m_count; ++i) {
+    if (m_networks[i].lastSuccess > sequence) {
+      sequence = m_networks[i].lastSuccess;
+      result = i;
+    }
+  }
+  return result;
+}
+
+size_t WifiCredentialStore::find(const String& ssid) const {
+  for (size_t i = 0; i < m_count; ++i) {
+    if (m_networks[i].ssid == ssid) {
+      return i;
+    }
+  }
+  return m_count;
+}
+
+int32_t WifiCredentialStore::score(const Credential& credential, int32_t rssi) const {
+  auto result = rssi - s_failurePenalty * static_cast<int32_t>(credential.failures);
+  if (credential.lastSuccess != 0 && credential.lastSuccess == m_successSequence) {
+    result += s_mostRecentBonus;
+  }
+  return result;
+}
+
+}  // namespace esp_gui
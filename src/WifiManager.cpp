@@ -3,64 +3,78 @@
 // Licensed under the terms of the MIT license
 //
 
-#include <DNSServer.h>
 #include <esp-gui/WifiManager.hpp>
+#include <algorithm>
 
 namespace esp_gui {
 
 void WifiManager::setup(bool showConfigPortal) {
   if (
     showConfigPortal || !loadAPsFromConfig() || connectMultiWiFi(true) != WL_CONNECTED) {
-    // Starts access point
-    while (!showConfigurationPortal()) {
-      m_logger.log(
-        yal::Level::WARNING, "Configuration did not yield valid wifi, retrying");
-    }
+    // Starts access point, serviced from loop()
+    startConfigurationPortal();
+    return;
   }
 
   checkWifi();
 }
 
 void WifiManager::loop() {
+  if (m_portalActive) {
+    servicePortal();
+  }
+
+  checkWifi();
+
   if (m_shouldScan) {
     m_shouldScan = false;
+    m_reconnectAfterScan = m_scanner.startScan(true);
+  }
+
+  m_scanner.loop();
+  if (m_scanner.generation() != m_apListGeneration) {
     setApList();
-    connectMultiWiFi(true);
+  }
+
+  if (m_reconnectAfterScan && !m_scanner.scanning()) {
+    // a scan asked for on the web page may have found a stored network
+    m_reconnectAfterScan = false;
+    reconnectNow("WiFi scan completed");
   }
 }
 
 bool WifiManager::loadAPsFromConfig() {
+  m_credentials.load();
+
   // Don't permit NULL SSID and password len < // MIN_AP_PASSWORD_SIZE (8)
   const auto ssid = m_config.value<std::string>("wifi_ssid");
+  const auto password = m_config.value<std::string>("wifi_password");
   if (ssid.empty() || ssid == "null") {
     m_logger.log(yal::Level::DEBUG, "SSID is invalid");
-    return false;
-  }
-
-  const auto password = m_config.value<std::string>("wifi_password");
-  if (password.empty()) {
+  } else if (password.empty()) {
     m_logger.log(yal::Level::DEBUG, "Password is invalid");
-    return false;
+  } else {
+    m_logger.log(
+      yal::Level::TRACE,
+      "Wifi config is valid: SSID: %, PW: %",
+      ssid.c_str(),
+      password.c_str());
+    m_credentials.add(ssid.c_str(), password.c_str());
   }
 
-  m_logger.log(
-    yal::Level::TRACE,
-    "Wifi config is valid: SSID: %, PW: %",
-    ssid.c_str(),
-    password.c_str());
-
-  return true;
+  return m_credentials.size() > 0;
 }
 
-[[noreturn]] bool WifiManager::showConfigurationPortal() {
+void WifiManager::startConfigurationPortal() {
   m_logger.log(yal::Level::DEBUG, "Starting access point");
 
-  DNSServer dnsServer;
-  dnsServer.setErrorReplyCode(DNSReplyCode::NoError);
+  m_dnsServer.setErrorReplyCode(DNSReplyCode::NoError);
 
   // SSID and PW for Config Portal
   const String ssid = "ESP-Config-AP-" + String(EspClass::getChipId(), HEX);
   const char* password = "ESPConfigAccessPoint";
+  // keep the station interface enabled to retry the stored networks
+  WiFi.mode(WIFI_AP_STA);
   WiFi.softAP(ssid, password);
 
   const auto hostname = "ESP";
@@ -69,16 +83,20 @@ bool WifiManager::loadAPsFromConfig() {
   const auto ip = WiFi.softAPIP();
 
   const auto dnsPort = 53;
-  if (!dnsServer.start(dnsPort, "*", WiFi.softAPIP())) {
+  if (!m_dnsServer.start(dnsPort, "*", ip)) {
     // No socket available
     m_logger.log(yal::Level::ERROR, "Can't start dns server");
   }
 
-  m_logger.log(yal::Level::DEBUG, "Starting Config Portal");
-  m_webServer.setup(hostname);
-
+  // the list is filled from loop() once the scan completed, results of the scan on
+  // boot are still fresh and used right away
+  m_scanner.startScan();
   setApList();
 
+  m_portalActive = true;
+  m_attempting = false;
+  scheduleReconnect(millis());
+
   m_logger.log(
     yal::Level::INFO,
     "Configuration portal ready at %, ssid %, password %",
@@ -87,51 +105,160 @@ bool WifiManager::loadAPsFromConfig() {
     password);
 
   logMemory(m_logger);
+}
 
-  // WebServer will restart ESP after configuration is done
-  while (true) {
-    dnsServer.processNextRequest();
-    delay(100);
-  }
+void WifiManager::stopConfigurationPortal() {
+  m_logger.log(yal::Level::INFO, "Stopping configuration portal");
+  m_dnsServer.stop();
+  WiFi.softAPdisconnect(true);
+  WiFi.mode(WIFI_STA);
+  m_portalActive = false;
 }
 
-void WifiManager::setApList() const {
-  m_logger.log(yal::Level::DEBUG, "Searching for available networks");
+void WifiManager::servicePortal() {
+  // answer up to s_maxDnsRequestsPerLoop queries per loop, captive portal detection
+  // gives up on slow dns. processNextRequest does not report whether one was pending.
+  for (auto i = 0; i < s_maxDnsRequestsPerLoop; ++i) {
+    m_dnsServer.processNextRequest();
+  }
+}
 
+void WifiManager::setApList() {
+  // before WebServer::setup the element map is empty, the scan is kept for the next
+  // loop() until the list can be filled
   const auto ssidElement = m_webServer.findElement<ListElement>(m_cfgWifiSsid);
   if (nullptr == ssidElement) {
     return;
   }
+  m_apListGeneration = m_scanner.generation();
 
-  WiFi.mode(WIFI_STA);
-  WiFi.disconnect();
-  delay(100);
-
-  int8_t networksFound = WiFi.scanNetworks();
-  for (int8_t i = 0; i < networksFound; i++) {
-    const auto ssid = WiFi.SSID(i);
-    m_logger.log(yal::Level::DEBUG, "Found SSID '%'", ssid.c_str());
-
-    ssidElement->addOption(ssid);
+  std::vector<FlashString> options;
+  options.reserve(m_scanner.size());
+  for (const auto& network : m_scanner) {
+    m_logger.log(
+      yal::Level::DEBUG, "Found SSID '%' (%)", network.ssid.data(), network.rssi);
+    options.emplace_back(network.ssid.data());
   }
+
+  ssidElement->setOptions(std::move(options));
 }
 
 bool WifiManager::checkWifi() {
+  const auto now = millis();
   if (WiFi.status() == WL_CONNECTED) {
+    if (!m_metrics.online()) {
+      onConnected(now);
+    }
     return true;
   }
 
-  m_logger.log(yal::Level::WARNING, "WIFi disconnected, reconnecting...");
-  if (connectMultiWiFi(false) == WL_CONNECTED) {
-    m_reconnectCount = 0;
-    return true;
+  if (m_metrics.online()) {
+    m_logger.log(yal::Level::WARNING, "WIFi disconnected, reconnecting...");
+    m_metrics.recordOffline(now);
+    m_reconnectPolicy.reset();
+    scheduleReconnect(now);
   }
 
-  m_logger.log(
-    yal::Level::WARNING, "WiFi reconnection failed, % times", ++m_reconnectCount);
+  serviceReconnect(now);
   return false;
 }
 
+const ConnectivityMetrics& WifiManager::metrics() {
+  if (WiFi.status() == WL_CONNECTED) {
+    m_metrics.setRssi(WiFi.RSSI());
+  }
+  return m_metrics;
+}
+
+void WifiManager::onConnected(unsigned long now) {
+  m_metrics.recordOnline(now);
+  m_metrics.setRssi(WiFi.RSSI());
+  if (m_attempting) {
+    m_attempting = false;
+    m_metrics.recordAttempt(true);
+    m_metrics.recordConnectTime(now - m_attemptStartMillis);
+    m_credentials.markSuccess(m_attemptCandidate);
+    m_credentials.save();
+  }
+
+  // does not wait, logs the connection details
+  waitForConnection(0);
+  storeFastConnect(WiFi.SSID());
+  m_reconnectPolicy.reset();
+  m_reconnectCount = 0;
+
+  if (m_portalActive) {
+    stopConfigurationPortal();
+  }
+}
+
+void WifiManager::serviceReconnect(unsigned long now) {
+  if (m_attempting) {
+    if (now - m_attemptStartMillis < s_attemptTimeout) {
+      return;
+    }
+
+    m_logger.log(
+      yal::Level::WARNING, "WiFi reconnection failed, % times", ++m_reconnectCount);
+    m_metrics.recordAttempt(false);
+    m_credentials.markFailure(m_attemptCandidate);
+    // the next attempt reloads the store, failures are capped so writes stop at the cap
+    m_credentials.save();
+    // only drops the station, a running access point stays up
+    WiFi.disconnect(false);
+    m_attempting = false;
+    scheduleReconnect(now);
+    return;
+  }
+
+  if (static_cast<long>(now - m_nextAttemptMillis) < 0) {
+    return;
+  }
+
+  // picks up credentials changed through the web interface
+  if (!loadAPsFromConfig()) {
+    scheduleReconnect(now);
+    return;
+  }
+
+  // rank with cached results only, refresh them in the background for the next try
+  WifiCredentialStore::Candidates candidates{};
+  const auto candidateCount = m_credentials.rank(m_scanner, candidates);
+  m_scanner.startScan();
+
+  m_attemptCandidate = candidates[m_attemptIndex++ % candidateCount].index;
+  const auto& credential = m_credentials[m_attemptCandidate];
+  m_logger.log(yal::Level::DEBUG, "Trying to connect to '%'", credential.ssid.c_str());
+  WiFi.begin(credential.ssid.c_str(), credential.password.c_str());
+  m_attempting = true;
+  m_attemptStartMillis = now;
+}
+
+void WifiManager::onCredentialsChanged() {
+  reconnectNow("WiFi credentials changed");
+}
+
+void WifiManager::reconnectNow(const char* reason) {
+  if (WiFi.status() == WL_CONNECTED || m_attempting) {
+    return;
+  }
+
+  // tried right away instead of after the backoff
+  m_logger.log(yal::Level::INFO, "%, reconnecting", reason);
+  m_reconnectPolicy.reset();
+  m_nextAttemptMillis = millis();
+}
+
+void WifiManager::scheduleReconnect(unsigned long now) {
+  auto delay = static_cast<unsigned long>(m_reconnectPolicy.nextDelay().count());
+  if (m_portalActive) {
+    // every attempt hops channels and disturbs clients of the access point
+    delay = std::max(delay, s_portalRetryInterval);
+  }
+  m_nextAttemptMillis = now + delay;
+  m_logger.log(yal::Level::DEBUG, "Next reconnect attempt in % ms", delay);
+}
+
 wl_status_t WifiManager::connectMultiWiFi(bool useFastConfig) {
   WiFi.forceSleepWake();
   m_logger.log(yal::Level::INFO, "Connecting WiFi...");
@@ -140,31 +267,126 @@ wl_status_t WifiManager::connectMultiWiFi(bool useFastConfig) {
   WiFi.mode(WIFI_STA);
   WiFi.setHostname(m_config.value<std::string>("wifi_hostname").c_str());
 
-  const auto ssid = m_config.value<std::string>("wifi_ssid");
-  const auto password = m_config.value<std::string>("wifi_password");
+  const auto mostRecent = m_credentials.mostRecent();
+  if (
+    useFastConfig && mostRecent < m_credentials.size() &&
+    connectFromCache(m_credentials[mostRecent])) {
+    return WL_CONNECTED;
+  }
+
+  // a single scan is used to rank all candidates. Boot blocks for it, nothing else
+  // runs before the connection and unseen networks would be tried in vain.
+  m_scanner.waitForResults();
+  WifiCredentialStore::Candidates candidates{};
+  const auto candidateCount = m_credentials.rank(m_scanner, candidates);
+
+  wl_status_t status = WL_DISCONNECTED;
+  for (size_t i = 0; i < candidateCount && status != WL_CONNECTED; ++i) {
+    status = connectCandidate(candidates[i], useFastConfig);
+  }
+  m_credentials.save();
+
+  if (status != WL_CONNECTED) {
+    m_logger.log(yal::Level::WARNING, "WiFi connect timeout");
+  }
+  return status;
+}
+
+wl_status_t WifiManager::connectCandidate(
+  const WifiCredentialStore::Candidate& candidate,
+  bool useFastConfig) {
+  const auto& credential = m_credentials[candidate.index];
+  const auto* network = candidate.network;
+
+  // adopted from
+  // https://github.com/roberttidey/WiFiManager/blob/feature_fastconnect/WiFiManager.cpp
+  const int32_t scan_rssi = -75;
+  const auto useBssid = useFastConfig && network != nullptr && network->rssi > scan_rssi;
 
-  fastConfig connectConfig{};
-  const auto hasFastConfig =
-    useFastConfig && getFastConnectConfig(ssid.c_str(), connectConfig);
-  wl_status_t status;
   uint8_t connectTimeout = 60;
-  if (hasFastConfig) {
+  if (useBssid) {
     connectTimeout = 30;
-    m_logger.log(yal::Level::DEBUG, "Using fast connect");
-    status = WiFi.begin(
-      ssid.c_str(), password.c_str(), connectConfig.channel, connectConfig.bssid, true);
+    m_logger.log(yal::Level::DEBUG, "Using fast connect for '%'", credential.ssid.c_str());
+    WiFi.begin(
+      credential.ssid.c_str(),
+      credential.password.c_str(),
+      network->channel,
+      network->bssid.data(),
+      true);
   } else {
-    m_logger.log(yal::Level::DEBUG, "Using standard connect");
-    status = WiFi.begin(ssid.c_str(), password.c_str());
+    m_logger.log(
+      yal::Level::DEBUG, "Using standard connect for '%'", credential.ssid.c_str());
+    WiFi.begin(credential.ssid.c_str(), credential.password.c_str());
+  }
+
+  const auto start = millis();
+  auto status = waitForConnection(connectTimeout);
+  if (status != WL_CONNECTED && useBssid) {
+    m_logger.log(yal::Level::WARNING, "Fast config failed, trying slow path");
+    WiFi.begin(credential.ssid.c_str(), credential.password.c_str());
+    status = waitForConnection(60);
   }
 
+  m_metrics.recordAttempt(status == WL_CONNECTED);
+  if (status == WL_CONNECTED) {
+    m_metrics.recordConnectTime(millis() - start);
+    m_credentials.markSuccess(candidate.index);
+    storeFastConnect(credential.ssid);
+  } else {
+    m_credentials.markFailure(candidate.index);
+    WiFi.disconnect();
+  }
+
+  return status;
+}
+
+bool WifiManager::connectFromCache(const WifiCredentialStore::Credential& credential) {
+  FastConnectCache::Entry entry{};
+  if (!m_fastConnectCache.load(credential.ssid, entry)) {
+    return false;
+  }
+
+  m_logger.log(yal::Level::DEBUG, "Using cached fast connect, channel %", entry.channel);
+  const auto reuseLease = m_reuseIpLease && entry.ip != 0;
+  if (reuseLease) {
+    WiFi.config(
+      IPAddress(entry.ip),
+      IPAddress(entry.gateway),
+      IPAddress(entry.subnet),
+      IPAddress(entry.dns));
+  }
+
+  WiFi.begin(
+    credential.ssid.c_str(),
+    credential.password.c_str(),
+    entry.channel,
+    entry.bssid.data(),
+    true);
+  const auto start = millis();
+  const auto connected = waitForConnection(30) == WL_CONNECTED;
+  m_metrics.recordAttempt(connected);
+  if (connected) {
+    m_metrics.recordConnectTime(millis() - start);
+    storeFastConnect(credential.ssid);
+    return true;
+  }
+
+  m_logger.log(yal::Level::WARNING, "Cached fast connect failed, falling back to scan");
+  m_fastConnectCache.invalidate();
+  WiFi.disconnect();
+  if (reuseLease) {
+    // all zero re-enables dhcp
+    WiFi.config(0U, 0U, 0U);
+  }
+  return false;
+}
+
+wl_status_t WifiManager::waitForConnection(uint8_t timeout) {
+  auto status = WiFi.status();
   int i = 0;
-  while ((i++ < connectTimeout) && (status != WL_CONNECTED)) {
+  while ((i++ < timeout) && (status != WL_CONNECTED)) {
     delay(100);
     status = WiFi.status();
-    if (status == WL_CONNECTED) {
-      break;
-    }
   }
 
   if (status == WL_CONNECTED) {
@@ -181,42 +403,35 @@ wl_status_t WifiManager::connectMultiWiFi(bool useFastConfig) {
       WiFi.channel(),
       WiFi.localIP().toString().c_str());
     //@formatter:on
-  } else {
-    m_logger.log(yal::Level::WARNING, "WiFi connect timeout");
-    if (hasFastConfig) {
-      m_logger.log(yal::Level::WARNING, "Fast config failed, trying slow path");
-      return connectMultiWiFi(false);
-    }
   }
 
   return status;
 }
 
-bool WifiManager::getFastConnectConfig(const String& ssid, fastConfig& config) {
-  // adopted from
-  // https://github.com/roberttidey/WiFiManager/blob/feature_fastconnect/WiFiManager.cpp
-  int8_t networksFound = WiFi.scanNetworks();
-  int32_t scan_rssi = -75;
-  for (auto i = 0; i < networksFound; i++) {
-    if (ssid == WiFi.SSID(i)) {
-      if (WiFi.RSSI(i) > scan_rssi) {
-        config.bssid = WiFi.BSSID(i);
-        config.channel = WiFi.channel(i);
-        return true;
-      }
-    }
+void WifiManager::storeFastConnect(const String& ssid) {
+  FastConnectCache::Entry entry{};
+  const auto* bssid = WiFi.BSSID();
+  if (bssid == nullptr) {
+    return;
   }
-  return false;
+
+  std::memcpy(entry.bssid.data(), bssid, entry.bssid.size());
+  entry.channel = WiFi.channel();
+  entry.ip = WiFi.localIP();
+  entry.gateway = WiFi.gatewayIP();
+  entry.subnet = WiFi.subnetMask();
+  entry.dns = WiFi.dnsIP();
+  m_fastConnectCache.store(ssid, entry);
 }
 
 void WifiManager::addWifiContainers() {
-  esp_gui::Container wifiSettings("WIFI Settings");
-  wifiSettings.addList({}, String("SSID"), m_cfgWifiSsid);
+  esp_gui::Container wifiSettings(F("WIFI Settings"));
+  wifiSettings.addList({}, F("SSID"), m_cfgWifiSsid);
   wifiSettings.addButton(
-    "Scan Wifi", m_scanWifiButton, [&]() { m_shouldScan = true; }, 15s);
+    F("Scan Wifi"), m_scanWifiButton, [&]() { m_shouldScan = true; }, 15s);
 
-  wifiSettings.addInput(InputElementType::PASSWORD, "Password", m_cfgWifiPassword);
-  wifiSettings.addInput(InputElementType::STRING, String("Hostname"), m_cfgWifiHostname);
+  wifiSettings.addInput(InputElementType::PASSWORD, F("Password"), m_cfgWifiPassword);
+  wifiSettings.addInput(InputElementType::STRING, F("Hostname"), m_cfgWifiHostname);
 
   m_webServer.addContainer(std::move(wifiSettings));
 }
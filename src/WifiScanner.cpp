@@ -0,0 +1,149 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <esp-gui/WifiScanner.hpp>
+
+namespace esp_gui {
+
+bool WifiScanner::startScan(bool force) {
+  if (m_scanning) {
+    return true;
+  }
+
+  if (!force && isFresh()) {
+    m_logger.log(yal::Level::DEBUG, "Scan results are still fresh, skipping scan");
+    return false;
+  }
+
+  // scanning requires the station interface, keep a running soft AP alive
+  if ((WiFi.getMode() & WIFI_STA) == 0) {
+    WiFi.enableSTA(true);
+  }
+
+  m_logger.log(yal::Level::DEBUG, "Starting asynchronous network scan");
+  const auto result = WiFi.scanNetworks(true);
+  if (result != WIFI_SCAN_RUNNING && result < 0) {
+    m_logger.log(yal::Level::ERROR, "Failed to start network scan: %", result);
+    return false;
+  }
+
+  m_scanning = true;
+  return true;
+}
+
+bool WifiScanner::waitForResults(std::chrono::milliseconds timeout) {
+  if (!m_scanning && isFresh()) {
+    return true;
+  }
+
+  if (!startScan()) {
+    return isFresh();
+  }
+
+  const auto start = millis();
+  while (m_scanning && (millis() - start) < static_cast<unsigned long>(timeout.count())) {
+    delay(10);
+    loop();
+  }
+
+  return !m_scanning;
+}
+
+void WifiScanner::loop() {
+  if (!m_scanning) {
+    return;
+  }
+
+  const auto networksFound = WiFi.scanComplete();
+  if (networksFound == WIFI_SCAN_RUNNING) {
+    return;
+  }
+
+  m_scanning = false;
+  if (networksFound < 0) {
+    m_logger.log(yal::Level::WARNING, "Network scan failed");
+    return;
+  }
+
+  collectResults(networksFound);
+  WiFi.scanDelete();
+}
+
+bool WifiScanner::isFresh() const {
+  return m_generation > 0 &&
+         (millis() - m_lastScanMillis) < static_cast<unsigned long>(m_ttl.count());
+}
+
+const WifiScanner::Network* WifiScanner::find(const String& ssid) const {
+  for (const auto& network : *this) {
+    if (ssid == network.ssid.data()) {
+      return &network;
+    }
+  }
+  return nullptr;
+}
+
+void WifiScanner::collectResults(int8_t networksFound) {
+  m_count = 0;
+  for (int8_t i = 0; i < networksFound; i++) {
+    insert(WiFi.SSID(i), WiFi.BSSID(i), WiFi.channel(i), WiFi.RSSI(i));
+  }
+
+  m_lastScanMillis = millis();
+  ++m_generation;
+  m_logger.log(
+    yal::Level::DEBUG,
+    "Scan found % networks, % unique kept",
+    static_cast<int>(networksFound),
+    m_count);
+}
+
+void WifiScanner::insert(
+  const String& ssid,
+  const uint8_t* bssid,
+  int32_t channel,
+  int32_t rssi) {
+  if (ssid.isEmpty() || ssid.length() > s_maxSsidLength) {
+    return;
+  }
+
+  size_t pos = m_count;
+  for (size_t i = 0; i < m_count; ++i) {
+    if (ssid == m_networks[i].ssid.data()) {
+      if (m_networks[i].rssi >= rssi) {
+        return;
+      }
+      // same ssid with a stronger signal, remove the old entry and re-insert below
+      pos = i;
+      break;
+    }
+  }
+
+  if (pos == m_count) {
+    if (m_count < s_maxNetworks) {
+      ++m_count;
+    } else if (m_networks[m_count - 1].rssi >= rssi) {
+      return;
+    }
+    pos = m_count - 1;
+  }
+
+  // shift weaker entries down to keep the table sorted by rssi
+  while (pos > 0 && m_networks[pos - 1].rssi < rssi) {
+    m_networks[pos] = m_networks[pos - 1];
+    --pos;
+  }
+
+  auto& network = m_networks[pos];
+  network.ssid.fill(0);
+  std::memcpy(network.ssid.data(), ssid.c_str(), ssid.length());
+  if (bssid != nullptr) {
+    std::memcpy(network.bssid.data(), bssid, s_bssidLength);
+  }
+  network.channel = channel;
+  network.rssi = rssi;
+}
+
+}  // namespace esp_gui
@@ -0,0 +1,53 @@
+// Loads the options of lists and dropdowns with data-options from /options
+// instead of rendering all of them into the page.
+
+function fetchOptions(name, offset, prefix) {
+    const query = new URLSearchParams({name: name, offset: offset, prefix: prefix});
+    return fetch('/options?' + query).then(function (response) {
+        return response.json();
+    });
+}
+
+// dropdowns load all pages once they get the focus, the selected option is rendered
+function loadDropdown(select, name, offset) {
+    fetchOptions(name, offset, '').then(function (page) {
+        page.options.forEach(function (option) {
+            if (option !== select.value) {
+                select.add(new Option(option, option));
+            }
+        });
+        const loaded = offset + page.options.length;
+        if (page.options.length > 0 && loaded < page.total) {
+            loadDropdown(select, name, loaded);
+        }
+    });
+}
+
+// lists only load the first page of options starting with the typed text
+function watchList(input, name) {
+    const list = document.getElementById(input.getAttribute('list'));
+    let timer;
+    const update = function () {
+        fetchOptions(name, 0, input.value).then(function (page) {
+            list.replaceChildren(...page.options.map(function (option) {
+                return new Option(option, option);
+            }));
+        });
+    };
+    input.addEventListener('focus', update, {once: true});
+    input.addEventListener('input', function () {
+        clearTimeout(timer);
+        timer = setTimeout(update, 200);
+    });
+}
+
+document.querySelectorAll('[data-options]').forEach(function (element) {
+    const name = element.dataset.options;
+    if (element.tagName === 'SELECT') {
+        element.addEventListener('focus', function () {
+            loadDropdown(element, name, 0);
+        }, {once: true});
+    } else {
+        watchList(element, name);
+    }
+});
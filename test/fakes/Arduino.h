@@ -0,0 +1,225 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_ARDUINO_H
+#define ESP_GUI_FAKE_ARDUINO_H
+
+// Minimal host replacement of the arduino core for the native test env.
+// Only covers what the sources built by the native env use.
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <array>
+#include <string>
+#include <type_traits>
+
+// flash is ordinary memory on the host
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+class __FlashStringHelper;
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+#define F(s) FPSTR(PSTR(s))
+
+#define HEX 16
+
+inline void* memcpy_P(void* dest, const void* src, size_t size) {
+  return memcpy(dest, src, size);
+}
+
+inline int memcmp_P(const void* lhs, const void* rhs, size_t size) {
+  return memcmp(lhs, rhs, size);
+}
+
+inline size_t strlen_P(PGM_P text) {
+  return strlen(text);
+}
+
+inline int strcmp_P(const char* lhs, PGM_P rhs) {
+  return strcmp(lhs, rhs);
+}
+
+inline int strncmp_P(const char* lhs, PGM_P rhs, size_t size) {
+  return strncmp(lhs, rhs, size);
+}
+
+class String : public std::string {
+ public:
+  using std::string::string;
+  String() = default;
+  String(const std::string& str) : std::string(str) {
+  }
+
+  String(const __FlashStringHelper* text) :
+      std::string(reinterpret_cast<const char*>(text)) {
+  }
+
+  explicit String(char c) : std::string(1, c) {
+  }
+
+  template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+  explicit String(T value) : std::string(std::to_string(value)) {
+  }
+
+  String(unsigned long value, unsigned char base) {
+    std::array<char, 33> text{};
+    char* end = text.data() + text.size() - 1;
+    do {
+      *--end = "0123456789abcdef"[value % base];
+      value /= base;
+    } while (value != 0);
+    assign(end);
+  }
+
+  [[nodiscard]] bool isEmpty() const {
+    return empty();
+  }
+
+  [[nodiscard]] long toInt() const {
+    return strtol(c_str(), nullptr, 10);
+  }
+
+  [[nodiscard]] bool startsWith(const String& prefix) const {
+    return compare(0, prefix.size(), prefix) == 0;
+  }
+
+  [[nodiscard]] bool endsWith(const String& suffix) const {
+    return size() >= suffix.size() &&
+      compare(size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  void remove(size_t index, size_t count) {
+    erase(index, count);
+  }
+
+  // used by the string writer of ArduinoJson
+  bool concat(const char* text) {
+    append(text);
+    return true;
+  }
+
+  using std::string::operator+=;
+
+  String& operator+=(const __FlashStringHelper* text) {
+    append(reinterpret_cast<const char*>(text));
+    return *this;
+  }
+};
+
+// required by the arduino string adapter of ArduinoJson
+class StringSumHelper : public String {};
+
+class Print {
+ public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size-- > 0) {
+      written += write(*buffer++);
+    }
+    return written;
+  }
+
+  size_t print(char c) {
+    return write(static_cast<uint8_t>(c));
+  }
+
+  size_t print(const char* text) {
+    return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+  }
+
+  size_t print(const String& text) {
+    return write(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+  }
+
+  size_t printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    std::string text(static_cast<size_t>(vsnprintf(nullptr, 0, format, copy)), '\0');
+    va_end(copy);
+    vsnprintf(text.data(), text.size() + 1, format, args);
+    va_end(args);
+    return write(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+  }
+};
+
+namespace fake {
+inline unsigned long s_millis = 0;
+inline uint32_t s_freeHeap = 40000;
+inline uint32_t s_maxFreeBlock = 30000;
+inline uint8_t s_fragmentation = 10;
+inline uint32_t s_random = 0x5eed;
+inline size_t s_resets = 0;
+inline std::array<uint32_t, 128> s_rtcMemory{};
+}  // namespace fake
+
+#define RANDOM_REG32 (fake::s_random)
+
+inline unsigned long millis() {
+  return fake::s_millis;
+}
+
+// time only passes when a test or a blocking wait advances it
+inline void delay(unsigned long ms) {
+  fake::s_millis += ms;
+}
+
+class EspClass {
+ public:
+  static uint32_t getFreeHeap() {
+    return fake::s_freeHeap;
+  }
+
+  static uint32_t getMaxFreeBlockSize() {
+    return fake::s_maxFreeBlock;
+  }
+
+  static uint8_t getHeapFragmentation() {
+    return fake::s_fragmentation;
+  }
+
+  static uint32_t getFreeContStack() {
+    return 4096;
+  }
+
+  static void reset() {
+    ++fake::s_resets;
+  }
+
+  static uint32_t getChipId() {
+    return 0xe59;
+  }
+
+  static uint32_t random() {
+    return fake::s_random;
+  }
+
+  static bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+    if (offset * 4 + size > fake::s_rtcMemory.size() * 4) {
+      return false;
+    }
+    memcpy(data, fake::s_rtcMemory.data() + offset, size);
+    return true;
+  }
+
+  static bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+    if (offset * 4 + size > fake::s_rtcMemory.size() * 4) {
+      return false;
+    }
+    memcpy(fake::s_rtcMemory.data() + offset, data, size);
+    return true;
+  }
+};
+
+#endif  // ESP_GUI_FAKE_ARDUINO_H
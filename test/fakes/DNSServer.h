@@ -0,0 +1,31 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_DNSSERVER_H
+#define ESP_GUI_FAKE_DNSSERVER_H
+
+// No queries arrive on the host
+
+#include <ESP8266WiFi.h>
+
+enum class DNSReplyCode { NoError = 0, ServerFailure = 2, NonExistentDomain = 3 };
+
+class DNSServer {
+ public:
+  void setErrorReplyCode(const DNSReplyCode& /*replyCode*/) {
+  }
+
+  bool start(uint16_t /*port*/, const String& /*domainName*/, const IPAddress& /*ip*/) {
+    return true;
+  }
+
+  void stop() {
+  }
+
+  void processNextRequest() {
+  }
+};
+
+#endif  // ESP_GUI_FAKE_DNSSERVER_H
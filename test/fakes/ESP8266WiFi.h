@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_ESP8266WIFI_H
+#define ESP_GUI_FAKE_ESP8266WIFI_H
+
+// Station and access point of the wifi interface. Nothing is connected on the host,
+// tests set the status and inspect the connection attempts in namespace fake.
+
+#include <Arduino.h>
+#include <array>
+#include <vector>
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7
+};
+
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+
+constexpr int8_t WIFI_SCAN_RUNNING = -1;
+constexpr int8_t WIFI_SCAN_FAILED = -2;
+
+class IPAddress {
+ public:
+  IPAddress() = default;
+
+  IPAddress(uint32_t address) {
+    std::memcpy(m_octets.data(), &address, m_octets.size());
+  }
+
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : m_octets({a, b, c, d}) {
+  }
+
+  operator uint32_t() const {
+    uint32_t address = 0;
+    std::memcpy(&address, m_octets.data(), m_octets.size());
+    return address;
+  }
+
+  [[nodiscard]] String toString() const {
+    std::array<char, 16> text{};
+    snprintf(
+      text.data(),
+      text.size(),
+      "%u.%u.%u.%u",
+      m_octets[0],
+      m_octets[1],
+      m_octets[2],
+      m_octets[3]);
+    return text.data();
+  }
+
+ private:
+  std::array<uint8_t, 4> m_octets{};
+};
+
+namespace fake {
+inline wl_status_t s_wifiStatus = WL_DISCONNECTED;
+// ssid of each WiFi.begin call
+inline std::vector<String> s_wifiBegins;
+}  // namespace fake
+
+class ESP8266WiFiClass {
+ public:
+  wl_status_t begin(
+    const char* ssid,
+    const char* /*password*/,
+    int32_t /*channel*/ = 0,
+    const uint8_t* /*bssid*/ = nullptr,
+    bool /*connect*/ = true) {
+    fake::s_wifiBegins.emplace_back(ssid);
+    return fake::s_wifiStatus;
+  }
+
+  bool config(
+    IPAddress /*local*/,
+    IPAddress /*gateway*/,
+    IPAddress /*subnet*/,
+    IPAddress /*dns*/ = IPAddress()) {
+    return true;
+  }
+
+  bool disconnect(bool /*wifiOff*/ = false) {
+    fake::s_wifiStatus = WL_DISCONNECTED;
+    return true;
+  }
+
+  [[nodiscard]] wl_status_t status() const {
+    return fake::s_wifiStatus;
+  }
+
+  bool mode(WiFiMode_t mode) {
+    m_mode = mode;
+    return true;
+  }
+
+  [[nodiscard]] WiFiMode_t getMode() const {
+    return m_mode;
+  }
+
+  bool enableSTA(bool enable) {
+    m_mode = static_cast<WiFiMode_t>(enable ? m_mode | WIFI_STA : m_mode & ~WIFI_STA);
+    return true;
+  }
+
+  bool forceSleepWake() {
+    return true;
+  }
+
+  bool setHostname(const char* /*hostname*/) {
+    return true;
+  }
+
+  bool softAP(const String& /*ssid*/, const char* /*password*/) {
+    return true;
+  }
+
+  bool softAPdisconnect(bool /*wifiOff*/) {
+    return true;
+  }
+
+  [[nodiscard]] IPAddress softAPIP() const {
+    return {192, 168, 4, 1};
+  }
+
+  [[nodiscard]] IPAddress localIP() const {
+    return {};
+  }
+
+  [[nodiscard]] IPAddress gatewayIP() const {
+    return {};
+  }
+
+  [[nodiscard]] IPAddress subnetMask() const {
+    return {};
+  }
+
+  [[nodiscard]] IPAddress dnsIP() const {
+    return {};
+  }
+
+  [[nodiscard]] String SSID() const {
+    return {};
+  }
+
+  [[nodiscard]] const uint8_t* BSSID() const {
+    return nullptr;
+  }
+
+  [[nodiscard]] int32_t channel() const {
+    return 0;
+  }
+
+  [[nodiscard]] int8_t RSSI() const {
+    return 0;
+  }
+
+  // scans complete right away and find nothing
+  int8_t scanNetworks(bool /*async*/) {
+    return WIFI_SCAN_RUNNING;
+  }
+
+  int8_t scanComplete() {
+    return 0;
+  }
+
+  void scanDelete() {
+  }
+
+  [[nodiscard]] String SSID(uint8_t /*index*/) const {
+    return {};
+  }
+
+  [[nodiscard]] uint8_t* BSSID(uint8_t /*index*/) {
+    return nullptr;
+  }
+
+  [[nodiscard]] int32_t channel(uint8_t /*index*/) const {
+    return 0;
+  }
+
+  [[nodiscard]] int32_t RSSI(uint8_t /*index*/) const {
+    return 0;
+  }
+
+ private:
+  WiFiMode_t m_mode = WIFI_OFF;
+};
+
+inline ESP8266WiFiClass WiFi;
+
+#endif  // ESP_GUI_FAKE_ESP8266WIFI_H
@@ -0,0 +1,26 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_ESP8266MDNS_H
+#define ESP_GUI_FAKE_ESP8266MDNS_H
+
+// Nothing is announced on the host
+
+#include <Arduino.h>
+
+class MDNSResponder {
+ public:
+  bool begin(const String& /*hostname*/) {
+    return true;
+  }
+
+  bool addService(const char* /*service*/, const char* /*protocol*/, uint16_t /*port*/) {
+    return true;
+  }
+};
+
+inline MDNSResponder MDNS;
+
+#endif  // ESP_GUI_FAKE_ESP8266MDNS_H
@@ -0,0 +1,594 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_ESPASYNCWEBSERVER_H
+#define ESP_GUI_FAKE_ESPASYNCWEBSERVER_H
+
+// Interface of ESPAsyncWebServer as far as the web server uses it. Requests are
+// built by the test and handled synchronously, a response writes its complete body
+// to the request when it is sent.
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <MD5Builder.h>
+#include <strings.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+enum WebRequestMethod : uint8_t {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+};
+
+using WebRequestMethodComposite = uint8_t;
+
+class AsyncWebServerRequest;
+
+using ArRequestHandlerFunction = std::function<void(AsyncWebServerRequest* request)>;
+using ArUploadHandlerFunction = std::function<void(
+  AsyncWebServerRequest* request,
+  const String& filename,
+  size_t index,
+  uint8_t* data,
+  size_t len,
+  bool final)>;
+using ArBodyHandlerFunction = std::function<void(
+  AsyncWebServerRequest* request,
+  uint8_t* data,
+  size_t len,
+  size_t index,
+  size_t total)>;
+using ArDisconnectHandler = std::function<void()>;
+using AwsResponseFiller =
+  std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)>;
+using AwsTemplateProcessor = std::function<String(const String& var)>;
+
+class AsyncClient {
+ public:
+  void close(bool /*now*/ = false) {
+    m_closed = true;
+  }
+
+  [[nodiscard]] bool closed() const {
+    return m_closed;
+  }
+
+ private:
+  bool m_closed = false;
+};
+
+class AsyncWebHeader {
+ public:
+  AsyncWebHeader(String name, String value) :
+      m_name(std::move(name)), m_value(std::move(value)) {
+  }
+
+  [[nodiscard]] const String& name() const {
+    return m_name;
+  }
+
+  [[nodiscard]] const String& value() const {
+    return m_value;
+  }
+
+ private:
+  String m_name;
+  String m_value;
+};
+
+class AsyncWebParameter {
+ public:
+  AsyncWebParameter(String name, String value, bool form = false, bool file = false) :
+      m_name(std::move(name)), m_value(std::move(value)), m_isForm(form), m_isFile(file) {
+  }
+
+  [[nodiscard]] const String& name() const {
+    return m_name;
+  }
+
+  [[nodiscard]] const String& value() const {
+    return m_value;
+  }
+
+  [[nodiscard]] bool isPost() const {
+    return m_isForm;
+  }
+
+  [[nodiscard]] bool isFile() const {
+    return m_isFile;
+  }
+
+ private:
+  String m_name;
+  String m_value;
+  bool m_isForm;
+  bool m_isFile;
+};
+
+class AsyncWebServerResponse {
+ public:
+  virtual ~AsyncWebServerResponse() = default;
+
+  virtual void setCode(int code) {
+    m_code = code;
+  }
+
+  virtual void setContentLength(size_t len) {
+    m_contentLength = len;
+  }
+
+  virtual void addHeader(const String& /*name*/, const String& /*value*/) {
+  }
+
+  virtual String _assembleHead(uint8_t /*version*/) {
+    return String();
+  }
+
+  virtual bool _started() const {
+    return false;
+  }
+
+  virtual bool _finished() const {
+    return false;
+  }
+
+  virtual bool _failed() const {
+    return false;
+  }
+
+  virtual bool _sourceValid() const {
+    return true;
+  }
+
+  virtual void _respond(AsyncWebServerRequest* /*request*/) {
+  }
+
+  virtual size_t _ack(AsyncWebServerRequest* /*request*/, size_t len, uint32_t /*time*/) {
+    return len;
+  }
+
+ protected:
+  /**
+   * Appends data to the body of the request, placeholders are replaced like the
+   * template processor of the library does it
+   */
+  void write(AsyncWebServerRequest* request, const uint8_t* data, size_t len);
+
+  int m_code = 0;
+  size_t m_contentLength = 0;
+  AwsTemplateProcessor m_template;
+
+ private:
+  static constexpr size_t s_maxNameLength = 32;
+  std::array<char, s_maxNameLength + 1> m_name{};
+  size_t m_nameLength = 0;
+  bool m_inPlaceholder = false;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+ public:
+  explicit AsyncBasicResponse(int code, const String& content = String()) :
+      m_content(content) {
+    m_code = code;
+  }
+
+  void _respond(AsyncWebServerRequest* request) override {
+    write(request, reinterpret_cast<const uint8_t*>(m_content.data()), m_content.size());
+  }
+
+ private:
+  String m_content;
+};
+
+class AsyncProgmemResponse : public AsyncWebServerResponse {
+ public:
+  AsyncProgmemResponse(
+    int code,
+    const uint8_t* content,
+    size_t len,
+    AwsTemplateProcessor callback) :
+      m_content(content), m_length(len) {
+    m_code = code;
+    m_template = std::move(callback);
+  }
+
+  void _respond(AsyncWebServerRequest* request) override {
+    write(request, m_content, m_length);
+  }
+
+ private:
+  const uint8_t* m_content;
+  size_t m_length;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse {
+ public:
+  // chunk size of the library for a small tcp window
+  static constexpr size_t s_chunkSize = 256;
+
+  AsyncChunkedResponse(
+    AwsResponseFiller callback,
+    AwsTemplateProcessor templateCallback) :
+      m_filler(std::move(callback)) {
+    m_code = 200;
+    m_template = std::move(templateCallback);
+  }
+
+  void _respond(AsyncWebServerRequest* request) override {
+    std::array<uint8_t, s_chunkSize> buffer{};
+    size_t index = 0;
+    size_t len = 0;
+    while ((len = m_filler(buffer.data(), buffer.size(), index)) > 0) {
+      write(request, buffer.data(), len);
+      index += len;
+    }
+  }
+
+ private:
+  AwsResponseFiller m_filler;
+};
+
+class AsyncFileResponse : public AsyncWebServerResponse {
+ public:
+  AsyncFileResponse(FS& fs, const String& path, AwsTemplateProcessor callback) :
+      m_file(fs.open(path.c_str(), "r")) {
+    m_code = 200;
+    m_template = std::move(callback);
+  }
+
+  void _respond(AsyncWebServerRequest* request) override {
+    std::array<uint8_t, AsyncChunkedResponse::s_chunkSize> buffer{};
+    size_t len = 0;
+    while ((len = m_file.read(buffer.data(), buffer.size())) > 0) {
+      write(request, buffer.data(), len);
+    }
+  }
+
+  [[nodiscard]] bool _sourceValid() const override {
+    return static_cast<bool>(m_file);
+  }
+
+ private:
+  File m_file;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+ public:
+  using Print::write;
+
+  AsyncResponseStream() {
+    m_code = 200;
+  }
+
+  size_t write(uint8_t c) override {
+    m_content += static_cast<char>(c);
+    return 1;
+  }
+
+  void _respond(AsyncWebServerRequest* request) override {
+    AsyncWebServerResponse::write(
+      request, reinterpret_cast<const uint8_t*>(m_content.data()), m_content.size());
+  }
+
+ private:
+  std::string m_content;
+};
+
+class AsyncWebServerRequest {
+ public:
+  AsyncWebServerRequest(WebRequestMethodComposite method, String url) :
+      m_method(method), m_url(std::move(url)) {
+  }
+
+  AsyncWebServerRequest(const AsyncWebServerRequest&) = delete;
+
+  ~AsyncWebServerRequest() {
+    free(_tempObject);
+  }
+
+  // freed with the request
+  void* _tempObject = nullptr;
+
+  [[nodiscard]] WebRequestMethodComposite method() const {
+    return m_method;
+  }
+
+  [[nodiscard]] const String& url() const {
+    return m_url;
+  }
+
+  void addHeader(const String& name, const String& value) {
+    m_headers.emplace_back(name, value);
+  }
+
+  void addParam(const String& name, const String& value, bool post = false) {
+    m_params.emplace_back(name, value, post);
+  }
+
+  void setContentLength(size_t len) {
+    m_contentLength = len;
+  }
+
+  [[nodiscard]] size_t contentLength() const {
+    return m_contentLength;
+  }
+
+  [[nodiscard]] bool hasHeader(const String& name) const {
+    return findHeader(name) != nullptr;
+  }
+
+  [[nodiscard]] String header(const char* name) const {
+    const auto* header = findHeader(name);
+    return header == nullptr ? String() : header->value();
+  }
+
+  AsyncWebHeader* getHeader(const String& name) {
+    return const_cast<AsyncWebHeader*>(findHeader(name));
+  }
+
+  [[nodiscard]] bool hasParam(const String& name, bool post = false, bool file = false)
+    const {
+    return findParam(name, post, file) != nullptr;
+  }
+
+  AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) {
+    return const_cast<AsyncWebParameter*>(findParam(name, post, file));
+  }
+
+  AsyncWebParameter* getParam(size_t num) {
+    return num < m_params.size() ? &m_params[num] : nullptr;
+  }
+
+  [[nodiscard]] size_t params() const {
+    return m_params.size();
+  }
+
+  AsyncClient* client() {
+    return &m_client;
+  }
+
+  void onDisconnect(ArDisconnectHandler fn) {
+    m_onDisconnect = std::move(fn);
+  }
+
+  AsyncWebServerResponse* beginResponse(
+    int code,
+    const String& /*contentType*/ = String(),
+    const String& content = String()) {
+    return new AsyncBasicResponse(code, content);
+  }
+
+  AsyncWebServerResponse* beginResponse(
+    FS& fs,
+    const String& path,
+    const String& /*contentType*/ = String(),
+    bool /*download*/ = false,
+    AwsTemplateProcessor callback = nullptr) {
+    return new AsyncFileResponse(fs, path, std::move(callback));
+  }
+
+  AsyncWebServerResponse* beginChunkedResponse(
+    const String& /*contentType*/,
+    AwsResponseFiller callback,
+    AwsTemplateProcessor templateCallback = nullptr) {
+    return new AsyncChunkedResponse(std::move(callback), std::move(templateCallback));
+  }
+
+  AsyncResponseStream* beginResponseStream(
+    const String& /*contentType*/,
+    size_t /*bufferSize*/ = 1460) {
+    return new AsyncResponseStream();
+  }
+
+  AsyncWebServerResponse* beginResponse_P(
+    int code,
+    const String& /*contentType*/,
+    const uint8_t* content,
+    size_t len,
+    AwsTemplateProcessor callback = nullptr) {
+    return new AsyncProgmemResponse(code, content, len, std::move(callback));
+  }
+
+  AsyncWebServerResponse* beginResponse_P(
+    int code,
+    const String& contentType,
+    PGM_P content,
+    AwsTemplateProcessor callback = nullptr) {
+    return beginResponse_P(
+      code,
+      contentType,
+      reinterpret_cast<const uint8_t*>(content),
+      strlen_P(content),
+      std::move(callback));
+  }
+
+  /**
+   * Writes the complete response to body() and keeps it until the request is deleted
+   */
+  void send(AsyncWebServerResponse* response) {
+    m_response.reset(response);
+    response->_respond(this);
+    response->_ack(this, m_body.size(), 0);
+  }
+
+  [[nodiscard]] bool sent() const {
+    return m_response != nullptr;
+  }
+
+  /**
+   * The body is only appended, reserve it to keep the test from allocating
+   */
+  void reserveBody(size_t size) {
+    m_body.reserve(size);
+  }
+
+  void appendBody(const char* data, size_t len) {
+    m_body.append(data, len);
+  }
+
+  [[nodiscard]] const std::string& body() const {
+    return m_body;
+  }
+
+ private:
+  [[nodiscard]] const AsyncWebHeader* findHeader(const String& name) const {
+    for (const auto& header : m_headers) {
+      if (strcasecmp(header.name().c_str(), name.c_str()) == 0) {
+        return &header;
+      }
+    }
+    return nullptr;
+  }
+
+  [[nodiscard]] const AsyncWebParameter* findParam(
+    const String& name,
+    bool post,
+    bool file) const {
+    for (const auto& param : m_params) {
+      if (param.name() == name && param.isPost() == post && param.isFile() == file) {
+        return &param;
+      }
+    }
+    return nullptr;
+  }
+
+  const WebRequestMethodComposite m_method;
+  const String m_url;
+  std::vector<AsyncWebHeader> m_headers;
+  std::vector<AsyncWebParameter> m_params;
+  size_t m_contentLength = 0;
+  AsyncClient m_client;
+  ArDisconnectHandler m_onDisconnect;
+  std::unique_ptr<AsyncWebServerResponse> m_response;
+  std::string m_body;
+};
+
+inline void AsyncWebServerResponse::write(
+  AsyncWebServerRequest* request,
+  const uint8_t* data,
+  size_t len) {
+  const auto* text = reinterpret_cast<const char*>(data);
+  if (!m_template) {
+    request->appendBody(text, len);
+    return;
+  }
+
+  for (size_t i = 0; i < len; ++i) {
+    const auto c = text[i];
+    if (!m_inPlaceholder) {
+      if (c == '%') {
+        m_inPlaceholder = true;
+        m_nameLength = 0;
+      } else {
+        request->appendBody(&c, 1);
+      }
+      continue;
+    }
+
+    if (c == '%') {
+      m_inPlaceholder = false;
+      if (m_nameLength == 0) {
+        request->appendBody("%", 1);
+        continue;
+      }
+      m_name[m_nameLength] = '\0';
+      const auto value = m_template(m_name.data());
+      request->appendBody(value.data(), value.size());
+    } else if (m_nameLength == s_maxNameLength) {
+      m_inPlaceholder = false;
+      request->appendBody("%", 1);
+      request->appendBody(m_name.data(), m_nameLength);
+      request->appendBody(&c, 1);
+    } else {
+      m_name[m_nameLength++] = c;
+    }
+  }
+}
+
+class AsyncWebServer;
+
+namespace fake {
+// server of the web server under test, it is constructed in place of its member
+inline AsyncWebServer* s_server = nullptr;
+}  // namespace fake
+
+class AsyncWebServer {
+ public:
+  explicit AsyncWebServer(uint16_t /*port*/) {
+    fake::s_server = this;
+  }
+
+  AsyncWebServer(const AsyncWebServer&) = delete;
+
+  ~AsyncWebServer() {
+    if (fake::s_server == this) {
+      fake::s_server = nullptr;
+    }
+  }
+
+  void begin() {
+  }
+
+  void on(
+    const char* uri,
+    WebRequestMethodComposite method,
+    ArRequestHandlerFunction onRequest,
+    ArUploadHandlerFunction /*onUpload*/ = nullptr,
+    ArBodyHandlerFunction onBody = nullptr) {
+    m_routes.push_back({uri, method, std::move(onRequest), std::move(onBody)});
+  }
+
+  void onNotFound(ArRequestHandlerFunction fn) {
+    m_notFound = std::move(fn);
+  }
+
+  /**
+   * Calls the handler of the first route matching method and url of the request.
+   * A body is passed to the body handler in chunks before.
+   */
+  void handle(AsyncWebServerRequest* request, const std::string& body = {}) {
+    for (const auto& route : m_routes) {
+      if ((route.method & request->method()) != 0 && route.uri == request->url()) {
+        request->setContentLength(body.size());
+        for (size_t index = 0; route.onBody && index < body.size();
+             index += s_bodyChunkSize) {
+          auto* data = reinterpret_cast<uint8_t*>(const_cast<char*>(body.data()));
+          const auto len = std::min(s_bodyChunkSize, body.size() - index);
+          route.onBody(request, data + index, len, index, body.size());
+        }
+        route.onRequest(request);
+        return;
+      }
+    }
+    if (m_notFound) {
+      m_notFound(request);
+    }
+  }
+
+ private:
+  struct Route {
+    String uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction onRequest;
+    ArBodyHandlerFunction onBody;
+  };
+
+  // size of the tcp segments the library receives a body in
+  static constexpr size_t s_bodyChunkSize = 1436;
+
+  std::vector<Route> m_routes;
+  ArRequestHandlerFunction m_notFound;
+};
+
+#endif  // ESP_GUI_FAKE_ESPASYNCWEBSERVER_H
@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_LITTLEFS_H
+#define ESP_GUI_FAKE_LITTLEFS_H
+
+// In memory file system for the native test env
+
+#include <Arduino.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+ public:
+  File() = default;
+  explicit File(std::string* content) : m_content(content) {
+  }
+
+  size_t read(uint8_t* buffer, size_t size) {
+    if (m_content == nullptr) {
+      return 0;
+    }
+    const auto len = std::min(size, m_content->size() - m_position);
+    memcpy(buffer, m_content->data() + m_position, len);
+    m_position += len;
+    return len;
+  }
+
+  size_t write(const char* data, size_t size) {
+    if (m_content == nullptr) {
+      return 0;
+    }
+    m_content->append(data, size);
+    return size;
+  }
+
+  size_t write(const uint8_t* data, size_t size) {
+    return write(reinterpret_cast<const char*>(data), size);
+  }
+
+  bool seek(size_t position, SeekMode mode = SeekSet) {
+    if (m_content == nullptr || mode != SeekSet || position > m_content->size()) {
+      return false;
+    }
+    m_position = position;
+    return true;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return m_content == nullptr ? 0 : m_content->size();
+  }
+
+  void close() {
+    m_content = nullptr;
+  }
+
+  operator bool() const {
+    return m_content != nullptr;
+  }
+
+ private:
+  std::string* m_content = nullptr;
+  size_t m_position = 0;
+};
+
+class FS {
+ public:
+  bool begin() {
+    m_mounted = true;
+    return true;
+  }
+
+  void end() {
+    m_mounted = false;
+  }
+
+  File open(const char* path, const char* mode) {
+    if (!m_mounted) {
+      return {};
+    }
+
+    auto& content = m_files[path];
+    if (mode[0] == 'w') {
+      content.clear();
+      ++m_writes[path];
+    }
+    return File(&content);
+  }
+
+  bool exists(const char* path) const {
+    return m_mounted && m_files.count(path) > 0;
+  }
+
+  bool remove(const char* path) {
+    return m_mounted && m_files.erase(path) > 0;
+  }
+
+  [[nodiscard]] bool mounted() const {
+    return m_mounted;
+  }
+
+  /**
+   * @return how often path was opened for writing since the last clear()
+   */
+  [[nodiscard]] size_t writes(const char* path) const {
+    const auto writes = m_writes.find(path);
+    return writes == m_writes.end() ? 0 : writes->second;
+  }
+
+  void clear() {
+    m_files.clear();
+    m_writes.clear();
+  }
+
+ private:
+  bool m_mounted = false;
+  std::map<std::string, std::string> m_files;
+  std::map<std::string, size_t> m_writes;
+};
+
+inline FS LittleFS;
+
+#endif  // ESP_GUI_FAKE_LITTLEFS_H
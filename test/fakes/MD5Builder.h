@@ -0,0 +1,40 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_MD5BUILDER_H
+#define ESP_GUI_FAKE_MD5BUILDER_H
+
+// Not md5, the digest only has to tell different data apart
+
+#include <Arduino.h>
+#include <array>
+
+class MD5Builder {
+ public:
+  void begin() {
+    m_digest.fill(0);
+    m_length = 0;
+  }
+
+  void add(const uint8_t* data, uint16_t length) {
+    for (uint16_t i = 0; i < length; ++i, ++m_length) {
+      auto& byte = m_digest[m_length % m_digest.size()];
+      byte = static_cast<uint8_t>(byte * 31U + data[i] + 1U);
+    }
+  }
+
+  void calculate() {
+  }
+
+  void getBytes(uint8_t* output) const {
+    memcpy(output, m_digest.data(), m_digest.size());
+  }
+
+ private:
+  std::array<uint8_t, 16> m_digest{};
+  size_t m_length = 0;
+};
+
+#endif  // ESP_GUI_FAKE_MD5BUILDER_H
@@ -0,0 +1,22 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_COREDECLS_H
+#define ESP_GUI_FAKE_COREDECLS_H
+
+#include <Arduino.h>
+
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0xffffffff) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  while (length-- > 0) {
+    crc ^= *bytes++;
+    for (auto bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1U) != 0 ? 0xedb88320 : 0);
+    }
+  }
+  return crc;
+}
+
+#endif  // ESP_GUI_FAKE_COREDECLS_H
@@ -0,0 +1,11 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_FAKE_UMM_MALLOC_H
+#define ESP_GUI_FAKE_UMM_MALLOC_H
+
+// The native env builds without UMM_STATS, nothing is used from here
+
+#endif  // ESP_GUI_FAKE_UMM_MALLOC_H
@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include "AllocationCounter.hpp"
+#include <cstdlib>
+#include <new>
+
+using esp_gui::test::AllocationCounter;
+
+#ifdef ESP_GUI_WRAP_MALLOC
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  AllocationCounter::record(size);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  AllocationCounter::record(count * size);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  AllocationCounter::record(size);
+  return __real_realloc(ptr, size);
+}
+}
+#endif
+
+static void* allocate(size_t size) {
+#ifndef ESP_GUI_WRAP_MALLOC
+  AllocationCounter::record(size);
+#endif
+  // with wrapped malloc this calls __wrap_malloc which counts the allocation
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(size_t size) {
+  void* ptr = allocate(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
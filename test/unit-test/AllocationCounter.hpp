@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#ifndef ESP_GUI_ALLOCATIONCOUNTER_HPP
+#define ESP_GUI_ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+namespace esp_gui::test {
+
+/**
+ * Counts heap allocations made while the counter exists.
+ * operator new is replaced in AllocationCounter.cpp, malloc, calloc and realloc are
+ * counted if the test is linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+ * and ESP_GUI_WRAP_MALLOC is defined.
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter() : m_allocations(s_allocations), m_bytes(s_bytes) {
+  }
+
+  [[nodiscard]] size_t allocations() const {
+    return s_allocations - m_allocations;
+  }
+
+  [[nodiscard]] size_t bytes() const {
+    return s_bytes - m_bytes;
+  }
+
+  static void record(size_t size) {
+    ++s_allocations;
+    s_bytes += size;
+  }
+
+ private:
+  static inline size_t s_allocations = 0;
+  static inline size_t s_bytes = 0;
+
+  const size_t m_allocations;
+  const size_t m_bytes;
+};
+
+}  // namespace esp_gui::test
+
+/**
+ * Fails the test if statement allocates more than budget times
+ */
+#define EXPECT_ALLOCATIONS_LE(budget, statement)                 \
+  do {                                                           \
+    const esp_gui::test::AllocationCounter allocationCounter;    \
+    statement;                                                   \
+    const auto allocations = allocationCounter.allocations();    \
+    EXPECT_LE(allocations, static_cast<size_t>(budget)) << #statement; \
+  } while (false)
+
+#endif  // ESP_GUI_ALLOCATIONCOUNTER_HPP
@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <gtest/gtest.h>
+
+#include <esp-gui/Configuration.hpp>
+#include <esp-gui/RequestMetrics.hpp>
+#include <esp-gui/WebServer.hpp>
+#include "AllocationCounter.hpp"
+
+namespace esp_gui::test {
+
+// Allocation budgets of paths which run on every request. The esp8266 has about
+// 40KB of heap, a new allocation in one of these paths fragments it on each request.
+
+TEST(AllocationCounterTest, countsNew) {
+  AllocationCounter counter;
+  auto value = std::make_unique<int>(1);
+  EXPECT_EQ(counter.allocations(), 1U);
+  EXPECT_GE(counter.bytes(), sizeof(int));
+}
+
+class ConfigurationAllocationTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LittleFS.clear();
+    m_config.setValue(m_intKey, 42);
+    m_config.setValue(m_stringKey, String("a value longer than the small string buffer"));
+    auto array = m_config.createArray(m_arrayKey);
+    array.add(1);
+    array.add(2);
+  }
+
+  Configuration m_config;
+  const String m_intKey = "int_key";
+  const String m_stringKey = "string_key";
+  const String m_arrayKey = "array_key";
+};
+
+TEST_F(ConfigurationAllocationTest, intValueDoesNotAllocate) {
+  int value = 0;
+  EXPECT_ALLOCATIONS_LE(0, value = m_config.value<int>(m_intKey));
+  EXPECT_EQ(value, 42);
+}
+
+TEST_F(ConfigurationAllocationTest, missingValueDoesNotAllocate) {
+  const String missing = "missing";
+  int value = 1;
+  EXPECT_ALLOCATIONS_LE(0, value = m_config.value<int>(missing));
+  EXPECT_EQ(value, 0);
+}
+
+TEST_F(ConfigurationAllocationTest, stringValueAllocatesOnlyTheCopy) {
+  String value;
+  EXPECT_ALLOCATIONS_LE(1, value = m_config.value<String>(m_stringKey));
+  EXPECT_EQ(value, "a value longer than the small string buffer");
+}
+
+TEST_F(ConfigurationAllocationTest, settingIntDoesNotAllocate) {
+  EXPECT_ALLOCATIONS_LE(0, m_config.setValue(m_intKey, 42));
+  EXPECT_ALLOCATIONS_LE(0, m_config.setValue(m_intKey, 7));
+  EXPECT_EQ(m_config.value<int>(m_intKey), 7);
+}
+
+TEST_F(ConfigurationAllocationTest, arrayDoesNotAllocate) {
+  size_t size = 0;
+  EXPECT_ALLOCATIONS_LE(0, size = m_config.array(m_arrayKey).size());
+  EXPECT_EQ(size, 2U);
+}
+
+class RequestMetricsAllocationTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    m_index = m_metrics.addRoute("/");
+    m_metrics.addRoute("/metrics");
+  }
+
+  RequestMetrics m_metrics;
+  size_t m_index = 0;
+};
+
+TEST_F(RequestMetricsAllocationTest, recordingDoesNotAllocate) {
+  EXPECT_ALLOCATIONS_LE(0, {
+    m_metrics.begin(m_index);
+    m_metrics.end();
+    m_metrics.responded(m_index, 200, 1024, 12);
+    m_metrics.sampleHeap();
+  });
+}
+
+TEST_F(RequestMetricsAllocationTest, renderingDoesNotAllocate) {
+  m_metrics.begin(m_index);
+  m_metrics.end();
+  m_metrics.responded(m_index, 200, 1024, 12);
+
+  // chunk size of the web server for a small tcp window
+  std::array<uint8_t, 256> buffer{};
+  RequestMetrics::RenderPosition position;
+  std::string text;
+  size_t chunks = 0;
+
+  // the text is collected outside of the counted section
+  for (;;) {
+    size_t len = 0;
+    EXPECT_ALLOCATIONS_LE(
+      0, len = m_metrics.render(buffer.data(), buffer.size(), position));
+    if (len == 0) {
+      break;
+    }
+    text.append(reinterpret_cast<const char*>(buffer.data()), len);
+    ++chunks;
+  }
+
+  EXPECT_GT(chunks, 1U);
+  EXPECT_NE(text.find("esp_gui_http_requests_total{route=\"/\"} 1\n"), std::string::npos);
+}
+
+class WebServerAllocationTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LittleFS.clear();
+  }
+
+  /**
+   * Renders / of a page with count inputs, the allocations of the request have to
+   * stay within the budget independent of the number of elements
+   */
+  void renderRoot(size_t count) {
+    Configuration config;
+    WebServer server(80, "esp-gui", config);
+    server.setPageStorage(WebServer::PageStorage::FLASH);
+
+    Container container(FlashString("Inputs"));
+    for (size_t i = 0; i < count; ++i) {
+      const String name = "input_" + String(i);
+      container.addInput(InputElementType::INT, FlashString(name), FlashString(name));
+      // fits the small string buffer, longer values are copied once each
+      config.setValue(name, static_cast<int>(i));
+    }
+    server.addContainer(std::move(container));
+    server.setup("esp-gui");
+
+    AsyncWebServerRequest request(HTTP_GET, "/");
+    request.addHeader("Host", "esp-gui.local");
+    request.reserveBody(s_bodyCapacity);
+
+    // the etag, the page reader, its filler, the response and its metered wrapper
+    EXPECT_ALLOCATIONS_LE(5, fake::s_server->handle(&request));
+
+    ASSERT_TRUE(request.sent());
+    EXPECT_LT(request.body().size(), s_bodyCapacity);
+    const String lastInput = "id=\"input_" + String(count - 1) + "\"";
+    EXPECT_NE(request.body().find(lastInput), std::string::npos);
+  }
+
+  static constexpr size_t s_bodyCapacity = 32768;
+};
+
+TEST_F(WebServerAllocationTest, renderingRootDoesNotAllocatePerElement) {
+  for (const size_t count : {1U, 8U, 32U}) {
+    SCOPED_TRACE(count);
+    renderRoot(count);
+  }
+}
+
+}  // namespace esp_gui::test
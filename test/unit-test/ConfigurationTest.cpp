@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <gtest/gtest.h>
+
+#include <esp-gui/Configuration.hpp>
+#include <cstdlib>
+
+namespace esp_gui::test {
+
+class ConfigurationTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LittleFS.clear();
+  }
+
+  Configuration m_config;
+};
+
+TEST_F(ConfigurationTest, setValuesCopiesStringsParsedInPlace) {
+  static constexpr const char* json =
+    R"({"name":"a value","networks":[{"ssid":"net","password":"secret"}]})";
+  auto* body = static_cast<char*>(std::malloc(strlen(json) + 1));
+  strcpy(body, json);
+
+  {
+    // a mutable input is parsed in place, like the body of an import
+    DynamicJsonDocument values(512);
+    ASSERT_EQ(deserializeJson(values, body), DeserializationError::Ok);
+    ASSERT_TRUE(m_config.setValues(values.as<JsonObjectConst>()));
+  }
+
+  memset(body, 'x', strlen(json));
+  std::free(body);
+
+  EXPECT_EQ(m_config.value<String>("name"), "a value");
+  const auto networks = m_config.array("networks");
+  ASSERT_EQ(networks.size(), 1U);
+  EXPECT_STREQ(networks[0]["ssid"].as<const char*>(), "net");
+  EXPECT_STREQ(networks[0]["password"].as<const char*>(), "secret");
+}
+
+TEST_F(ConfigurationTest, setValuesChangesNothingIfValuesDoNotFit) {
+  m_config.setValue("kept", 1);
+  const auto version = m_config.version();
+
+  DynamicJsonDocument values(m_config.capacity() * 2);
+  values["kept"] = 2;
+  values["large"] = String(m_config.capacity(), 'x');
+  EXPECT_FALSE(m_config.setValues(values.as<JsonObjectConst>()));
+
+  EXPECT_EQ(m_config.value<int>("kept"), 1);
+  EXPECT_FALSE(m_config.contains("large"));
+  EXPECT_EQ(m_config.version(), version);
+}
+
+TEST_F(ConfigurationTest, serializeWritesJson) {
+  class StringPrint : public Print {
+   public:
+    using Print::write;
+
+    size_t write(uint8_t c) override {
+      text += static_cast<char>(c);
+      return 1;
+    }
+
+    std::string text;
+  };
+
+  m_config.setValue("int", 42);
+  m_config.setValue("text", String("value"));
+
+  StringPrint out;
+  m_config.serialize(out);
+  EXPECT_EQ(out.text, R"({"int":42,"text":"value"})");
+}
+
+TEST_F(ConfigurationTest, fileSystemStaysMountedUntilTheLastHandle) {
+  {
+    Configuration::FileSystemHandle response;
+    ASSERT_TRUE(response.begin());
+    {
+      Configuration::FileSystemHandle store;
+      ASSERT_TRUE(store.begin());
+    }
+    EXPECT_TRUE(LittleFS.mounted());
+  }
+  EXPECT_FALSE(LittleFS.mounted());
+}
+
+TEST_F(ConfigurationTest, lockUnmountsTheFileSystem) {
+  {
+    Configuration::FileSystemHandle response;
+    ASSERT_TRUE(response.begin());
+    Configuration::lockFileSystem(true);
+    EXPECT_FALSE(LittleFS.mounted());
+
+    Configuration::FileSystemHandle store;
+    EXPECT_FALSE(store.begin());
+    Configuration::lockFileSystem(false);
+  }
+
+  // the handle from before the lock does not count for the new mount
+  Configuration::FileSystemHandle store;
+  EXPECT_TRUE(store.begin());
+  EXPECT_TRUE(LittleFS.mounted());
+}
+
+}  // namespace esp_gui::test
@@ -0,0 +1,28 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <gtest/gtest.h>
+
+#include <esp-gui/FlashString.hpp>
+
+namespace esp_gui::test {
+
+static const char s_progmemText[] PROGMEM = "in flash";
+
+TEST(FlashStringTest, progmemStaysInFlash) {
+  const auto text = FlashString::fromProgmem(s_progmemText);
+  EXPECT_TRUE(text.inFlash());
+  EXPECT_EQ(text.length(), strlen(s_progmemText));
+  EXPECT_EQ(text.compare("in flash"), 0);
+  EXPECT_EQ(text.toString(), "in flash");
+}
+
+TEST(FlashStringTest, pointerIsCopiedAsRam) {
+  const auto text = FlashString(static_cast<const char*>("in ram"));
+  EXPECT_FALSE(text.inFlash());
+  EXPECT_EQ(text.toString(), "in ram");
+}
+
+}  // namespace esp_gui::test
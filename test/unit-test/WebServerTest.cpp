@@ -1,22 +1,182 @@
-////
-//// Copyright (c) 2022 Alexander Mohr
-//// Licensed under the terms of the MIT license
 //
-//#include <gmock/gmock.h>
-//#include <gtest/gtest.h>
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
 //
-//#include <yal/appender/ArduinoMQTT.hpp>
-//#include <yal/yal.hpp>
-//#include <string>
-//
-// using std::string_literals::operator""s;
-//
-// class WebServerTest : public testing::Test {
-//    void SetUp() override {
-//
-//    }
-//};
-//
-// TEST_F(WebServerTest, bar) {
-//
-//}
+
+#include <gtest/gtest.h>
+
+#include <esp-gui/WebServer.hpp>
+
+namespace esp_gui::test {
+
+class WebServerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LittleFS.clear();
+    m_server.setPageStorage(WebServer::PageStorage::FLASH);
+
+    Container container(FlashString("Settings"));
+    container.addInput(InputElementType::INT, FlashString("Interval"), m_intervalKey);
+    container.addInput(
+      InputElementType::PASSWORD, FlashString("Password"), m_passwordKey);
+    m_server.addContainer(std::move(container));
+    m_server.setup("esp-gui");
+  }
+
+  std::string handle(AsyncWebServerRequest& request, const std::string& body = {}) {
+    request.addHeader("Host", "esp-gui.local");
+    fake::s_server->handle(&request, body);
+    EXPECT_TRUE(request.sent());
+    return request.body();
+  }
+
+  Configuration m_config;
+  WebServer m_server{80, "esp-gui", m_config};
+  const String m_intervalKey = "interval";
+  const String m_passwordKey = "password";
+};
+
+TEST_F(WebServerTest, rootRendersContainersWithValues) {
+  m_config.setValue(m_intervalKey, 42);
+
+  AsyncWebServerRequest request(HTTP_GET, "/");
+  const auto body = handle(request);
+  EXPECT_NE(body.find("<h3>Settings</h3>"), std::string::npos);
+  EXPECT_NE(body.find(R"(id="interval")"), std::string::npos);
+  EXPECT_NE(body.find(R"(value="42")"), std::string::npos);
+  EXPECT_EQ(body.find("%interval%"), std::string::npos);
+}
+
+TEST_F(WebServerTest, unknownRouteIsNotFound) {
+  AsyncWebServerRequest request(HTTP_GET, "/missing");
+  EXPECT_NE(handle(request).find("<h1>404</h1>"), std::string::npos);
+}
+
+TEST_F(WebServerTest, postRejectsInvalidNumbers) {
+  m_config.setValue(m_intervalKey, 42);
+
+  AsyncWebServerRequest request(HTTP_POST, "/");
+  request.addParam(m_intervalKey, "fast", true);
+  EXPECT_EQ(handle(request), "Invalid value of interval");
+  EXPECT_EQ(m_config.value<int>(m_intervalKey), 42);
+}
+
+TEST_F(WebServerTest, exportLeavesOutSecretsUnlessAsked) {
+  m_server.addConfigKey("networks", [](JsonVariantConst) { return true; }, true);
+  m_config.setValue(m_intervalKey, 42);
+  m_config.setValue(m_passwordKey, "secret");
+  // spans several chunks of the response
+  const String name(600, 'n');
+  m_config.setValue("name", name);
+  m_config.createArray("networks").add("secret network");
+
+  AsyncWebServerRequest redacted(HTTP_GET, "/config/export");
+  DynamicJsonDocument values(m_config.capacity());
+  ASSERT_EQ(deserializeJson(values, handle(redacted)), DeserializationError::Ok);
+  EXPECT_EQ(values[m_intervalKey], 42);
+  EXPECT_EQ(values["name"], name);
+  EXPECT_FALSE(values.containsKey(m_passwordKey));
+  EXPECT_FALSE(values.containsKey("networks"));
+
+  AsyncWebServerRequest complete(HTTP_GET, "/config/export");
+  complete.addParam("secrets", "1");
+  values.clear();
+  ASSERT_EQ(deserializeJson(values, handle(complete)), DeserializationError::Ok);
+  EXPECT_EQ(values[m_passwordKey], "secret");
+  EXPECT_EQ(values["networks"][0], "secret network");
+  EXPECT_EQ(values["name"], name);
+}
+
+TEST_F(WebServerTest, importLargerThanTheConfigurationIsRejected) {
+  const auto json = R"({"interval":1,"name":")" + std::string(m_config.capacity(), 'n') +
+    R"("})";
+
+  AsyncWebServerRequest request(HTTP_POST, "/config/import");
+  request.addHeader("Content-Type", "application/json");
+  EXPECT_EQ(
+    handle(request, json),
+    "Import of " + std::to_string(json.size()) + " bytes exceeds the limit of " +
+      std::to_string(m_config.capacity()) + " bytes");
+  EXPECT_FALSE(m_config.contains("name"));
+}
+
+TEST(WebServerFileSystemTest, responseKeepsTheFileSystemMounted) {
+  LittleFS.clear();
+  Configuration config;
+  WebServer server(80, "esp-gui", config);
+  Container container(FlashString("Settings"));
+  container.addInput(InputElementType::STRING, FlashString("Name"), FlashString("name"));
+  server.addContainer(std::move(container));
+  server.setup("esp-gui");
+  ASSERT_FALSE(LittleFS.mounted());
+
+  {
+    AsyncWebServerRequest request(HTTP_GET, "/");
+    request.addHeader("Host", "esp-gui.local");
+    fake::s_server->handle(&request);
+    EXPECT_NE(request.body().find(R"(id="name")"), std::string::npos);
+    // the library keeps reading the file after the handler returned
+    EXPECT_TRUE(LittleFS.mounted());
+  }
+  EXPECT_FALSE(LittleFS.mounted());
+}
+
+class WebServerPageCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LittleFS.clear();
+    fake::s_millis = 0;
+    Container container(FlashString("Settings"));
+    container.addInput(InputElementType::STRING, FlashString("Name"), m_nameKey);
+    m_server.addContainer(std::move(container));
+  }
+
+  void view() {
+    AsyncWebServerRequest request(HTTP_GET, "/");
+    request.addHeader("Host", "esp-gui.local");
+    fake::s_server->handle(&request);
+    EXPECT_NE(request.body().find(R"(id="name")"), std::string::npos);
+  }
+
+  [[nodiscard]] size_t cacheWrites() const {
+    return LittleFS.writes("/index.cache.html");
+  }
+
+  Configuration m_config;
+  WebServer m_server{80, "esp-gui", m_config};
+  const String m_nameKey = "name";
+};
+
+TEST_F(WebServerPageCacheTest, rewritesAreRateLimited) {
+  m_server.setPageCacheInterval(60s);
+  m_server.setup("esp-gui");
+
+  view();
+  EXPECT_EQ(cacheWrites(), 1U);
+
+  // changes within the interval are rendered per view
+  for (auto i = 0; i < 5; ++i) {
+    fake::s_millis += 1000;
+    m_config.setValue(m_nameKey, String(i));
+    view();
+  }
+  EXPECT_EQ(cacheWrites(), 1U);
+
+  fake::s_millis += 60000;
+  view();
+  EXPECT_EQ(cacheWrites(), 2U);
+  view();
+  EXPECT_EQ(cacheWrites(), 2U);
+}
+
+TEST_F(WebServerPageCacheTest, zeroIntervalDisablesTheCache) {
+  m_server.setPageCacheInterval(0s);
+  m_server.setup("esp-gui");
+
+  view();
+  m_config.setValue(m_nameKey, "changed");
+  view();
+  EXPECT_EQ(cacheWrites(), 0U);
+}
+
+}  // namespace esp_gui::test
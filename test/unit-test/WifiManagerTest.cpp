@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+
+#include <gtest/gtest.h>
+
+#include <esp-gui/WifiManager.hpp>
+
+namespace esp_gui::test {
+
+class WifiManagerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LittleFS.clear();
+    fake::s_millis = 0;
+    fake::s_wifiStatus = WL_DISCONNECTED;
+    fake::s_wifiBegins.clear();
+  }
+
+  void addNetwork(JsonArray networks, const char* ssid, uint32_t lastSuccess) {
+    auto network = networks.createNestedObject();
+    network["ssid"] = ssid;
+    network["password"] = "password";
+    network["last_success"] = lastSuccess;
+  }
+
+  // runs loop() until the next connection attempt started
+  String nextAttempt() {
+    const auto attempts = fake::s_wifiBegins.size();
+    for (auto i = 0; i < 1000 && fake::s_wifiBegins.size() == attempts; ++i) {
+      fake::s_millis += 1000;
+      m_wifiManager.loop();
+    }
+    return fake::s_wifiBegins.size() == attempts ? String() : fake::s_wifiBegins.back();
+  }
+
+  Configuration m_config;
+  WebServer m_server{80, "esp-gui", m_config};
+  WifiManager m_wifiManager{m_config, m_server};
+};
+
+TEST_F(WifiManagerTest, failedReconnectsLowerTheRank) {
+  // no network is in range, "home" ranks first because it was connected last
+  auto networks = m_config.createArray(WifiCredentialStore::configKey());
+  addNetwork(networks, "home", 1);
+  addNetwork(networks, "office", 0);
+
+  EXPECT_EQ(nextAttempt(), "home");
+  // the second attempt takes the second best candidate, which "home" became after
+  // its first failure
+  EXPECT_EQ(nextAttempt(), "home");
+  EXPECT_EQ(nextAttempt(), "office");
+
+  const auto stored = m_config.array(WifiCredentialStore::configKey());
+  ASSERT_EQ(stored.size(), 2U);
+  EXPECT_EQ(stored[0]["ssid"], "home");
+  EXPECT_EQ(stored[0]["failures"], 2);
+  EXPECT_EQ(stored[1]["failures"], 0);
+}
+
+}  // namespace esp_gui::test
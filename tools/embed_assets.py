@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Alexander Mohr
+# Licensed under the terms of the MIT license
+#
+"""Embeds the web assets of src/html into include/esp-gui/generated/WebAssets.hpp.
+
+Runs as PlatformIO pre script before each build and can be called directly:
+
+    embed_assets.py
+
+index.html is minified and split at the containers comment into the start and
+the end of the page. Both stay uncompressed because the server expands the
+%name% templates in them. style.css and options.js are minified and gzipped,
+the server sends them as they are with the content encoding gzip.
+Each asset gets a content hash which is used as ETag.
+"""
+
+import gzip
+import hashlib
+import inspect
+import os
+import re
+
+CONTAINERS_MARKER = "<!-- containers -->"
+
+# bytes per line of the generated arrays
+LINE_BYTES = 16
+
+HEADER = """//
+// Copyright (c) 2022 Alexander Mohr
+// Licensed under the terms of the MIT license
+//
+// Generated by tools/embed_assets.py from src/html, do not edit.
+// Only include from one translation unit, the arrays are not shared.
+//
+
+#ifndef ESP_GUI_GENERATED_WEBASSETS_HPP
+#define ESP_GUI_GENERATED_WEBASSETS_HPP
+
+#include <Arduino.h>
+
+namespace esp_gui::assets {{
+{assets}
+}}  // namespace esp_gui::assets
+
+#endif  // ESP_GUI_GENERATED_WEBASSETS_HPP
+"""
+
+
+def minify_html(html):
+    html = re.sub(r"<!--(?!\s*containers\s*-->).*?-->", "", html, flags=re.S)
+    html = re.sub(r"\s+", " ", html)
+    html = re.sub(r">\s+<", "><", html)
+    return html.strip()
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{}:;,>])\s*", r"\1", css)
+    css = css.replace(";}", "}")
+    return css.strip()
+
+
+def minify_js(js):
+    # only whitespace and line comments, newlines are kept for the semicolon rules
+    lines = (line.strip() for line in js.splitlines())
+    return "\n".join(line for line in lines if line and not line.startswith("//"))
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def c_array(name, data):
+    lines = []
+    for offset in range(0, len(data), LINE_BYTES):
+        chunk = data[offset:offset + LINE_BYTES]
+        lines.append("  " + ", ".join("0x%02x" % byte for byte in chunk) + ",")
+    return "\n".join([
+        "",
+        "static const uint8_t %s[] PROGMEM = {" % name,
+        *lines,
+        "};",
+        "static constexpr size_t %sLength = %d;" % (name, len(data)),
+    ])
+
+
+def etag(name, data):
+    return "static const char %sETag[] PROGMEM = \"\\\"%s\\\"\";" % (
+        name, content_hash(data))
+
+
+def generate(root):
+    html_dir = os.path.join(root, "src", "html")
+    with open(os.path.join(html_dir, "index.html"), encoding="utf-8") as file:
+        index = minify_html(file.read())
+    with open(os.path.join(html_dir, "style.css"), encoding="utf-8") as file:
+        style = minify_css(file.read()).encode("utf-8")
+    with open(os.path.join(html_dir, "options.js"), encoding="utf-8") as file:
+        script = minify_js(file.read()).encode("utf-8")
+
+    start, marker, end = index.partition(CONTAINERS_MARKER)
+    if not marker:
+        raise ValueError("index.html has no %s" % CONTAINERS_MARKER)
+
+    # mtime 0 keeps the output and with it the build reproducible
+    assets = "\n".join([
+        c_array("s_indexStart", start.encode("utf-8")),
+        c_array("s_indexEnd", end.encode("utf-8")),
+        c_array("s_styleGzip", gzip.compress(style, 9, mtime=0)),
+        etag("s_style", style),
+        c_array("s_optionsScriptGzip", gzip.compress(script, 9, mtime=0)),
+        etag("s_optionsScript", script),
+    ])
+    return HEADER.format(assets=assets)
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as file:
+            if file.read() == content:
+                return False
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "w", encoding="utf-8") as file:
+        file.write(content)
+    return True
+
+
+def main():
+    # scons executes the script without __file__
+    script = inspect.getframeinfo(inspect.currentframe()).filename
+    root = os.path.dirname(os.path.dirname(os.path.abspath(script)))
+    output = os.path.join(root, "include", "esp-gui", "generated", "WebAssets.hpp")
+    if write_if_changed(output, generate(root)):
+        print("Generated %s" % os.path.relpath(output, root))
+
+
+main()
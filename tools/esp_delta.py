@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Alexander Mohr
+# Licensed under the terms of the MIT license
+#
+"""Creates patches for the delta update of esp_gui::UpdateManager.
+
+The base has to be the firmware.bin which is running on the device.
+
+    esp_delta.py old/firmware.bin new/firmware.bin update.delta
+    curl -F size=... -F md5=... -F file=@update.delta \\
+        http://<device>/updateFirmwareDelta__upload
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"EGD1"
+OP_COPY = 0x01
+OP_LITERAL = 0x02
+
+# shorter matches are not worth the 9 bytes of a copy operation
+BLOCK_SIZE = 16
+MAX_CANDIDATES = 8
+
+
+def index_base(base):
+    index = {}
+    for offset in range(len(base) - BLOCK_SIZE + 1):
+        candidates = index.setdefault(base[offset:offset + BLOCK_SIZE], [])
+        if len(candidates) < MAX_CANDIDATES:
+            candidates.append(offset)
+    return index
+
+
+def match_length(base, base_offset, target, target_offset):
+    length = 0
+    limit = min(len(base) - base_offset, len(target) - target_offset)
+    # compare in blocks first, most matches are long
+    step = 256
+    while length + step <= limit and \
+            base[base_offset + length:base_offset + length + step] == \
+            target[target_offset + length:target_offset + length + step]:
+        length += step
+    while length < limit and base[base_offset + length] == target[target_offset + length]:
+        length += 1
+    return length
+
+
+def create_patch(base, target):
+    index = index_base(base)
+    patch = bytearray(MAGIC)
+    patch += struct.pack("<I", len(base))
+    patch += hashlib.md5(base).digest()
+    patch += struct.pack("<I", len(target))
+
+    literal = bytearray()
+    position = 0
+    # code that did not change keeps its order, try the continuation first
+    expected_offset = None
+
+    def flush_literal():
+        if literal:
+            patch.extend(struct.pack("<BI", OP_LITERAL, len(literal)))
+            patch.extend(literal)
+            literal.clear()
+
+    while position < len(target):
+        candidates = index.get(target[position:position + BLOCK_SIZE], [])
+        if expected_offset is not None and expected_offset not in candidates:
+            candidates = [expected_offset] + candidates
+
+        best_offset, best_length = 0, 0
+        for offset in candidates:
+            if offset >= len(base):
+                continue
+            length = match_length(base, offset, target, position)
+            if length > best_length:
+                best_offset, best_length = offset, length
+
+        if best_length >= BLOCK_SIZE:
+            flush_literal()
+            patch += struct.pack("<BII", OP_COPY, best_offset, best_length)
+            position += best_length
+            expected_offset = best_offset + best_length
+        else:
+            literal.append(target[position])
+            position += 1
+            if expected_offset is not None:
+                expected_offset += 1
+
+    flush_literal()
+    return bytes(patch)
+
+
+def apply_patch(base, patch):
+    """Reference decoder, used to check the created patch."""
+    if patch[:4] != MAGIC:
+        raise ValueError("not a delta patch")
+    base_size, = struct.unpack_from("<I", patch, 4)
+    target_size, = struct.unpack_from("<I", patch, 24)
+    if base_size != len(base) or patch[8:24] != hashlib.md5(base).digest():
+        raise ValueError("patch does not match base")
+
+    result = bytearray()
+    position = 28
+    while position < len(patch):
+        op = patch[position]
+        if op == OP_COPY:
+            offset, length = struct.unpack_from("<II", patch, position + 1)
+            result += base[offset:offset + length]
+            position += 9
+        elif op == OP_LITERAL:
+            length, = struct.unpack_from("<I", patch, position + 1)
+            result += patch[position + 5:position + 5 + length]
+            position += 5 + length
+        else:
+            raise ValueError("unknown operation")
+
+    if len(result) != target_size:
+        raise ValueError("size mismatch")
+    return bytes(result)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("base", help="firmware running on the device")
+    parser.add_argument("target", help="new firmware")
+    parser.add_argument("patch", help="output file")
+    args = parser.parse_args()
+
+    with open(args.base, "rb") as file:
+        base = file.read()
+    with open(args.target, "rb") as file:
+        target = file.read()
+
+    patch = create_patch(base, target)
+    if apply_patch(base, patch) != target:
+        sys.exit("patch verification failed")
+
+    with open(args.patch, "wb") as file:
+        file.write(patch)
+
+    print("patch:  %d bytes (%.1f%% of the image)" % (len(patch), 100.0 * len(patch) / len(target)))
+    print("size:   %d" % len(target))
+    print("md5:    %s" % hashlib.md5(target).hexdigest())
+    print("sha256: %s" % hashlib.sha256(target).hexdigest())
+
+
+if __name__ == "__main__":
+    main()
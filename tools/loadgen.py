@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Alexander Mohr
+# Licensed under the terms of the MIT license
+#
+"""Drives concurrent requests against an esp-gui web server and reports latency.
+
+The scenario is a json file with weighted steps, the same file works for a device
+and for a server running on the host:
+
+    loadgen.py http://192.168.4.1 --clients 4 --duration 30
+    loadgen.py http://localhost:8080 --scenario my_scenario.json --json result.json
+
+Each step has a name, method, path, weight and optionally "form" (url encoded
+fields) or "upload" (multipart file with field, filename and size in bytes).
+Redirects are not followed, every status below 400 counts as success.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import random
+import socket
+import sys
+import threading
+import time
+import urllib.parse
+import uuid
+
+DEFAULT_SCENARIO = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                "loadgen_scenario.json")
+
+
+class Result:
+    def __init__(self, step, latency, status, size, error):
+        self.step = step
+        self.latency = latency
+        self.status = status
+        self.size = size
+        self.error = error
+
+
+def build_body(step):
+    if "form" in step:
+        body = urllib.parse.urlencode(step["form"]).encode()
+        return body, "application/x-www-form-urlencoded"
+
+    if "upload" in step:
+        upload = step["upload"]
+        boundary = uuid.uuid4().hex
+        # starts with zero so the firmware updater rejects it instead of flashing
+        payload = bytes(1) + os.urandom(max(upload.get("size", 1024) - 1, 0))
+        head = ("--%s\r\nContent-Disposition: form-data; name=\"%s\"; filename=\"%s\"\r\n"
+                "Content-Type: application/octet-stream\r\n\r\n"
+                % (boundary, upload.get("field", "file"),
+                   upload.get("filename", "upload.bin"))).encode()
+        tail = ("\r\n--%s--\r\n" % boundary).encode()
+        return head + payload + tail, "multipart/form-data; boundary=" + boundary
+
+    return None, None
+
+
+def run_step(target, step, timeout):
+    body, content_type = build_body(step)
+    headers = {"Connection": "close"}
+    if content_type:
+        headers["Content-Type"] = content_type
+
+    connection_class = http.client.HTTPSConnection if target.scheme == "https" \
+        else http.client.HTTPConnection
+    connection = connection_class(target.hostname, target.port, timeout=timeout)
+    start = time.monotonic()
+    try:
+        connection.request(step["method"], step["path"], body=body, headers=headers)
+        response = connection.getresponse()
+        size = len(response.read())
+        latency = time.monotonic() - start
+        error = None if response.status < 400 else "http %d" % response.status
+        return Result(step["name"], latency, response.status, size, error)
+    except (socket.timeout, TimeoutError):
+        return Result(step["name"], time.monotonic() - start, None, 0, "timeout")
+    except (OSError, http.client.HTTPException) as exception:
+        return Result(step["name"], time.monotonic() - start, None, 0,
+                      type(exception).__name__)
+    finally:
+        connection.close()
+
+
+def worker(target, steps, weights, args, deadline, counter, results, lock, seed):
+    rng = random.Random(seed)
+    while time.monotonic() < deadline:
+        with lock:
+            if args.requests and counter[0] >= args.requests:
+                return
+            counter[0] += 1
+        step = rng.choices(steps, weights)[0]
+        result = run_step(target, step, args.timeout)
+        with lock:
+            results.append(result)
+        if args.think:
+            time.sleep(args.think)
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def summarize(results, elapsed):
+    groups = {}
+    for result in results:
+        groups.setdefault(result.step, []).append(result)
+    groups["total"] = results
+
+    summary = {}
+    for name, group in groups.items():
+        latencies = [r.latency for r in group if r.error is None]
+        errors = [r for r in group if r.error is not None]
+        timeouts = [r for r in errors if r.error == "timeout"]
+        sizes = [r.size for r in group if r.error is None]
+        statuses = {}
+        for result in group:
+            key = str(result.status) if result.status else result.error
+            statuses[key] = statuses.get(key, 0) + 1
+        summary[name] = {
+            "requests": len(group),
+            "throughput_rps": len(group) / elapsed if elapsed else 0.0,
+            "error_rate": len(errors) / len(group) if group else 0.0,
+            "timeout_rate": len(timeouts) / len(group) if group else 0.0,
+            "p50_ms": percentile(latencies, 0.50) * 1000,
+            "p99_ms": percentile(latencies, 0.99) * 1000,
+            "max_ms": max(latencies) * 1000 if latencies else 0.0,
+            "mean_bytes": sum(sizes) / len(sizes) if sizes else 0.0,
+            "max_bytes": max(sizes) if sizes else 0,
+            "statuses": statuses,
+        }
+    return summary
+
+
+def print_summary(summary, elapsed, clients):
+    print("%d clients, %.1f s" % (clients, elapsed))
+    header = "%-10s %8s %8s %7s %7s %9s %9s %9s %10s  %s" % (
+        "step", "requests", "req/s", "errors", "timeout", "p50 ms", "p99 ms", "max ms",
+        "bytes", "status")
+    print(header)
+    print("-" * len(header))
+    for name, values in summary.items():
+        statuses = " ".join("%s:%d" % item for item in sorted(values["statuses"].items()))
+        print("%-10s %8d %8.2f %6.1f%% %6.1f%% %9.1f %9.1f %9.1f %10.0f  %s" % (
+            name, values["requests"], values["throughput_rps"],
+            values["error_rate"] * 100, values["timeout_rate"] * 100,
+            values["p50_ms"], values["p99_ms"], values["max_ms"], values["mean_bytes"],
+            statuses))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("target", help="base url, e.g. http://192.168.4.1")
+    parser.add_argument("--scenario", default=DEFAULT_SCENARIO, help="scenario json file")
+    parser.add_argument("--clients", type=int, default=4, help="concurrent clients")
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds to run")
+    parser.add_argument("--requests", type=int, default=0,
+                        help="stop after this many requests, 0 for no limit")
+    parser.add_argument("--timeout", type=float, default=10.0, help="request timeout")
+    parser.add_argument("--think", type=float, default=0.0,
+                        help="pause of each client between requests in seconds")
+    parser.add_argument("--seed", type=int, default=1, help="seed of the step selection")
+    parser.add_argument("--json", help="also write the summary to this file")
+    args = parser.parse_args()
+
+    target = urllib.parse.urlparse(args.target)
+    if not target.hostname:
+        sys.exit("target has to be an url like http://192.168.4.1")
+
+    with open(args.scenario) as file:
+        scenario = json.load(file)
+    steps = [step for step in scenario["steps"] if step.get("weight", 1) > 0]
+    if not steps:
+        sys.exit("scenario has no step with a weight above 0")
+    weights = [step.get("weight", 1) for step in steps]
+
+    results = []
+    counter = [0]
+    lock = threading.Lock()
+    start = time.monotonic()
+    deadline = start + args.duration
+    threads = [threading.Thread(target=worker,
+                                args=(target, steps, weights, args, deadline, counter,
+                                      results, lock, args.seed + index))
+               for index in range(args.clients)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - start
+
+    summary = summarize(results, elapsed)
+    print_summary(summary, elapsed, args.clients)
+    if args.json:
+        with open(args.json, "w") as file:
+            json.dump({"clients": args.clients, "elapsed_s": elapsed, "steps": summary},
+                      file, indent=2)
+
+    total = summary["total"]
+    return 1 if total["requests"] and total["error_rate"] > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())